@@ -0,0 +1,30 @@
+/*
+ * Layout of the time page the driver publishes through
+ * /dev/pcf85263-<bus>-<addr>, shared by the kernel driver and the
+ * userspace library in userspace/. The page is mapped read-only.
+ *
+ * seq is odd while the driver writes the page. A reader copies the fields
+ * between two reads of an even seq, with read barriers in between, and
+ * retries if the two differ. The RTC time at CLOCK_MONOTONIC t is then
+ * rtc_sec.rtc_nsec + (t - mono_ns).
+ */
+#ifndef PCF85263_PAGE_H
+#define PCF85263_PAGE_H
+
+#include <linux/types.h>
+
+#define PCF85263_PAGE_VERSION	1
+
+#define PCF85263_PAGE_VALID	(1U << 0)	/* a sample is present */
+
+struct pcf85263_time_page {
+	__u32	seq;
+	__u32	version;
+	__u32	flags;
+	__u32	interval_ms;	/* refresh interval, 0 on reads only */
+	__s64	rtc_sec;	/* seconds since the epoch */
+	__s64	rtc_nsec;	/* the middle of the hundredth that was read */
+	__u64	mono_ns;	/* CLOCK_MONOTONIC at the sample */
+};
+
+#endif /* PCF85263_PAGE_H */
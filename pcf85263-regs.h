@@ -0,0 +1,166 @@
+/*
+ * NXP PCF85263/PCF85363 (and PCF85063) register map, shared by the kernel
+ * driver and the userspace library in userspace/. Kernel style BIT() and
+ * GENMASK() are expected to be defined by the includer.
+ */
+#ifndef PCF85263_REGS_H
+#define PCF85263_REGS_H
+
+/*
+ * Date/Time registers
+ */
+#define DT_100THS	0x00
+#define DT_SECS		0x01
+#define DT_MINUTES	0x02
+#define DT_HOURS	0x03
+#define DT_DAYS		0x04
+#define DT_WEEKDAYS	0x05
+#define DT_MONTHS	0x06
+#define DT_YEARS	0x07
+
+/*
+ * Stopwatch mode reuses the date/time block for an elapsed-time counter
+ */
+#define SW_HR_XX_XX_00	0x03
+#define SW_HR_XX_00_XX	0x04
+#define SW_HR_00_XX_XX	0x05
+
+/*
+ * Alarm registers
+ */
+#define DT_SECOND_ALM1	0x08
+#define DT_MINUTE_ALM1	0x09
+#define DT_HOUR_ALM1	0x0a
+#define DT_DAY_ALM1	0x0b
+#define DT_MONTH_ALM1	0x0c
+#define DT_MINUTE_ALM2	0x0d
+#define DT_HOUR_ALM2	0x0e
+#define DT_WEEKDAY_ALM2	0x0f
+#define DT_ALARM_EN	0x10
+
+/*
+ * Time stamp registers
+ */
+#define DT_TIMESTAMP1	0x11
+#define DT_TIMESTAMP2	0x17
+#define DT_TIMESTAMP3	0x1d
+#define DT_TS_MODE	0x23
+
+#define TS_MODE_TSR3M	GENMASK(7, 6)
+#define TS_MODE_TSR3_VDD	(3 << 6)	/* last switch back to VDD */
+
+/*
+ * control registers
+ */
+#define CTRL_OFFSET	0x24
+#define CTRL_OSCILLATOR	0x25
+#define CTRL_BATTERY	0x26
+#define CTRL_PIN_IO	0x27
+#define CTRL_FUNCTION	0x28
+#define CTRL_INTA_EN	0x29
+#define CTRL_INTB_EN	0x2a
+#define CTRL_FLAGS	0x2b
+#define CTRL_RAMBYTE	0x2c
+#define CTRL_WDOG	0x2d
+#define CTRL_STOP_EN	0x2e
+#define CTRL_RESETS	0x2f
+#define CTRL_RAM	0x40
+
+#define ALRM_SEC_A1E	BIT(0)
+#define ALRM_MIN_A1E	BIT(1)
+#define ALRM_HR_A1E	BIT(2)
+#define ALRM_DAY_A1E	BIT(3)
+#define ALRM_MON_A1E	BIT(4)
+#define ALRM_MIN_A2E	BIT(5)
+#define ALRM_HR_A2E	BIT(6)
+#define ALRM_DAY_A2E	BIT(7)
+
+#define INT_WDIE	BIT(0)
+#define INT_BSIE	BIT(1)
+#define INT_TSRIE	BIT(2)
+#define INT_A2IE	BIT(3)
+#define INT_A1IE	BIT(4)
+#define INT_OIE		BIT(5)
+#define INT_PIE		BIT(6)
+#define INT_ILP		BIT(7)
+
+#define FLAGS_TSR1F	BIT(0)
+#define FLAGS_TSR2F	BIT(1)
+#define FLAGS_TSR3F	BIT(2)
+#define FLAGS_BSF	BIT(3)
+#define FLAGS_WDF	BIT(4)
+#define FLAGS_A1F	BIT(5)
+#define FLAGS_A2F	BIT(6)
+#define FLAGS_PIF	BIT(7)
+
+#define PIN_IO_INTAPM	GENMASK(1, 0)
+#define PIN_IO_INTA_CLK	0
+#define PIN_IO_INTA_BAT	1
+#define PIN_IO_INTA_OUT	2
+#define PIN_IO_INTA_HIZ	3
+#define PIN_IO_TSPM	GENMASK(3, 2)
+#define PIN_IO_TSPM_INTB	(1 << 2)
+#define PIN_IO_CLKPM	BIT(7)
+
+#define FUNC_100TH	BIT(7)
+#define FUNC_PI		GENMASK(6, 5)
+#define FUNC_PI_SHIFT	5
+#define FUNC_PI_SEC	1
+#define FUNC_PI_MIN	2
+#define FUNC_PI_HOUR	3
+#define FUNC_RTCM	BIT(4)
+#define FUNC_STOPM	BIT(3)
+#define FUNC_COF	GENMASK(2, 0)
+#define FUNC_COF_LOW	7
+
+#define OSC_OFFM	BIT(6)
+#define OSC_12_24	BIT(5)
+#define OSC_LOWJ	BIT(4)
+#define OSC_OSCD	GENMASK(3, 2)
+#define OSC_OSCD_SHIFT	2
+#define OSC_CL		GENMASK(1, 0)
+
+#define SECS_OS		BIT(7)
+#define HOURS_PM	BIT(5)	/* in 12-hour mode */
+
+#define STOP_EN_STOP	BIT(0)
+
+#define RESET_CPR	0xa4
+
+/*
+ * PCF85063 family: control registers first, then the time block without
+ * hundredths. The COF field has the same codes as on the PCF85263.
+ */
+#define PCF85063_CTRL1		0x00
+#define PCF85063_CTRL2		0x01
+#define PCF85063_OFFSET		0x02
+#define PCF85063_RAMBYTE	0x03
+#define PCF85063_DT_SECS	0x04
+#define PCF85063_DT_YEARS	0x0a
+#define PCF85063A_TIMER_VALUE	0x10
+#define PCF85063A_TIMER_MODE	0x11
+
+#define PCF85063_CTRL1_STOP	BIT(5)
+#define PCF85063_CTRL1_12_24	BIT(1)
+
+#define NVRAM_SIZE	0x01
+#define RAM_SIZE	0x40
+
+#define SNAPSHOT_SIZE	(CTRL_RESETS + 1)
+
+/*
+ * CTRL_FLAGS..CTRL_RESETS, then the address wraps to DT_100THS..DT_YEARS
+ */
+#define STATUS_TIME	(CTRL_RESETS - CTRL_FLAGS + 1)
+#define STATUS_SIZE	(STATUS_TIME + DT_YEARS + 1)
+
+/*
+ * Register dump format, as read from the registers sysfs attribute and
+ * written by pcf85263ctl dump: a 16 byte header (magic, version, regs_len,
+ * ram_len, reserved, le64 CLOCK_REALTIME ns), then regs_len bytes of
+ * registers from 0x00 and ram_len bytes of RAM from CTRL_RAM.
+ */
+#define REGDUMP_MAGIC	"P263"
+#define REGDUMP_VERSION	1
+
+#endif /* PCF85263_REGS_H */
@@ -0,0 +1,1441 @@
+/*
+ * Simulated PCF85263 and stress harness for rtc-pcf85263.
+ *
+ * Registers an i2c adapter with two PCF85263 register models, at 0x51 and
+ * 0x52, and instantiates rtc-pcf85263 on both, with INTA of the first on a
+ * simulated interrupt. Writing to pcf85263-sim/run in debugfs then loads
+ * the driver from reader and setter threads through the rtc class, while
+ * an hrtimer keeps raising the periodic flag, for 1, 2, 4 ... up to readers
+ * reader threads. Next to them, the bypass threads take the ways into the
+ * driver that do not go through the rtc core: the mode and stopwatch
+ * attributes, the registers dump, the time page refresh and the group of
+ * both chips. The model checks every transfer: no read may find the clock
+ * stopped or the time registers half written. pcf85263-sim/results has
+ * the last run as JSON.
+ *
+ * For testing only; it needs no hardware.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ */
+#include <linux/module.h>
+#include <linux/stringify.h>
+#include <linux/i2c.h>
+#include <linux/rtc.h>
+#include <linux/bcd.h>
+#include <linux/delay.h>
+#include <linux/ktime.h>
+#include <linux/hrtimer.h>
+#include <linux/kthread.h>
+#include <linux/sched.h>
+#include <linux/debugfs.h>
+#include <linux/seq_file.h>
+#include <linux/spinlock.h>
+#include <linux/mutex.h>
+#include <linux/atomic.h>
+#include <linux/math64.h>
+#include <linux/vmalloc.h>
+#include <linux/irq_sim.h>
+#include <linux/fs.h>
+#include <linux/of.h>
+#include <linux/of_platform.h>
+#include <linux/platform_device.h>
+#include <asm/unaligned.h>
+
+#include "pcf85263-regs.h"
+
+#define SIM_ADDR		0x51	/* chip n at SIM_ADDR + n */
+#define SIM_CHIPS		2
+#define SIM_REGS		(CTRL_RAM + RAM_SIZE)
+#define SIM_MAX_READERS		64
+#define SIM_MAX_SETTERS		8
+#define SIM_MAX_STEPS		7	/* 1, 2, 4 ... SIM_MAX_READERS */
+#define SIM_MAX_IRQ_HZ		10000
+#define SIM_MIN_DURATION_MS	100
+#define SIM_TOLERANCE		2	/* s, between a read and the time set */
+/* every other set moves the clock by this, different in every field */
+#define SIM_SHIFT		(86400 + 3600 + 60 + 1)
+#define DT_ALL			GENMASK(DT_YEARS, DT_100THS)
+#define SIM_STOPWATCH		44284567	/* 123:00:45.67 in hundredths */
+#define SIM_PAGE_MS		10
+#define SIM_PHANDLE		0x85263000
+/* the registers attribute: header, register file and RAM */
+#define SIM_DUMP_TIMESTAMP	8
+#define SIM_DUMP_HDR		16
+#define SIM_DUMP_LEN		(SIM_DUMP_HDR + SNAPSHOT_SIZE + RAM_SIZE)
+
+static unsigned int readers = 4;
+module_param(readers, uint, 0644);
+MODULE_PARM_DESC(readers, "reader threads, doubling from 1 up to this");
+
+static unsigned int setters = 1;
+module_param(setters, uint, 0644);
+MODULE_PARM_DESC(setters, "setter threads");
+
+static unsigned int set_interval_ms = 10;
+module_param(set_interval_ms, uint, 0644);
+MODULE_PARM_DESC(set_interval_ms, "pause between the sets of each setter");
+
+static unsigned int irq_hz = 100;
+module_param(irq_hz, uint, 0644);
+MODULE_PARM_DESC(irq_hz, "periodic interrupts per second, 0 for none");
+
+static unsigned int duration_ms = 2000;
+module_param(duration_ms, uint, 0644);
+MODULE_PARM_DESC(duration_ms, "length of each step");
+
+static unsigned int bus_khz = 100;
+module_param(bus_khz, uint, 0644);
+MODULE_PARM_DESC(bus_khz, "simulated bus clock, 0 for transfers that take no time");
+
+static bool bypass = true;
+module_param(bypass, bool, 0644);
+MODULE_PARM_DESC(bypass, "also run the threads that bypass the rtc core");
+
+/*
+ * Latency histogram in microseconds: 1 us buckets below HIST_LINEAR, then
+ * HIST_SUB buckets per power of two, so within 1.6% up to over an hour.
+ */
+#define HIST_LINEAR	1024
+#define HIST_SUB	64
+#define HIST_BUCKETS	(HIST_LINEAR + 22 * HIST_SUB)
+
+struct sim_hist {
+	u64	count;
+	u64	max;
+	u32	buckets[HIST_BUCKETS];
+};
+
+struct sim_chip {
+	spinlock_t	lock;
+	u8		regs[SIM_REGS];
+	u8		ptr;
+	bool		stopped;
+	time64_t	base_sec;	/* chip time at anchor */
+	unsigned int	base_hths;
+	ktime_t		anchor;
+	unsigned long	dt_dirty;	/* time registers written since */
+	ktime_t		pif_raised;
+	/* counted per step */
+	unsigned long	stopped_reads;
+	unsigned long	torn_reads;
+	unsigned long	irqs;
+	unsigned long	missed_irqs;	/* raised while PIF was still set */
+	struct sim_hist	irq_hist;	/* PIF raised to cleared */
+};
+
+enum sim_kind {
+	SIM_READER,
+	SIM_SETTER,
+	SIM_GROUP,	/* sets and reads of the group */
+	SIM_MODE,	/* mode and stopwatch attributes */
+	SIM_DUMP,	/* registers attribute */
+	SIM_PAGE,	/* time page refresh */
+	SIM_KINDS,
+};
+
+struct sim_worker {
+	struct task_struct	*task;
+	enum sim_kind		kind;
+	struct rtc_device	*rtc;
+	struct sim_hist		hist;
+	unsigned long		ops;
+	unsigned long		errors;
+	unsigned long		bad;
+};
+
+struct sim_step {
+	unsigned int	readers;
+	u64		reads;
+	u64		read_p50, read_p99, read_p999, read_max;
+	u64		sets;
+	u64		set_p99, set_max;
+	unsigned long	irqs, missed_irqs;
+	u64		irq_p99, irq_max;
+	unsigned long	group_ops, mode_cycles, dumps, page_kicks;
+	unsigned long	errors;
+	unsigned long	stopped_reads;
+	unsigned long	torn_reads;
+	unsigned long	bad_reads;
+	unsigned long	group_bad, stopwatch_bad, dump_bad;
+};
+
+#ifdef CONFIG_OF_DYNAMIC
+#define SIM_PROPS	5
+
+struct sim_node {
+	struct device_node	np;
+	struct property		props[SIM_PROPS];
+	unsigned int		nprops;
+	char			full_name[16];
+};
+#endif
+
+static struct pcf85263_sim {
+	struct i2c_adapter	adap;
+	struct i2c_client	*clients[SIM_CHIPS];
+	struct sim_chip		chips[SIM_CHIPS];
+	struct hrtimer		timer;
+	ktime_t			period;
+	atomic_t		set_seq;
+	atomic_t		mode_seq;	/* odd while chip 0 is moved */
+	int			normalized;	/* -1 until checked */
+	struct dentry		*dir;
+	struct mutex		run_lock;	/* one run, and its results */
+	struct sim_step		steps[SIM_MAX_STEPS];
+	unsigned int		nsteps;
+	unsigned int		run_setters;
+	unsigned int		run_set_interval_ms;
+	unsigned int		run_irq_hz;
+	unsigned int		run_duration_ms;
+	unsigned int		run_bus_khz;
+	bool			run_bypass;
+	/* for the bypass threads, during a run */
+	struct rtc_device	*group_rtc;
+	struct file		*mode_file;
+	struct file		*stopwatch_file;
+	struct file		*regs_file;
+	struct file		*page_file;
+#ifdef CONFIG_IRQ_SIM
+	struct irq_sim		irq_sim;
+#endif
+#ifdef CONFIG_OF_DYNAMIC
+	struct sim_node		bus;
+	struct sim_node		rtcs[SIM_CHIPS];
+	struct sim_node		group;
+	__be32			phandles[SIM_CHIPS];
+	__be32			page_ms;
+	struct of_changeset	changeset;
+	bool			applied;
+	struct platform_device	*group_pdev;
+#endif
+} sim;
+
+static void sim_hist_add(struct sim_hist *h, s64 us)
+{
+	unsigned int shift, b;
+
+	if (us < 0)
+		us = 0;
+
+	if (us < HIST_LINEAR) {
+		b = us;
+	} else {
+		shift = fls64(us) - 7;
+		b = min_t(u64, HIST_LINEAR + (shift - 4) * HIST_SUB +
+			  (us >> shift) - HIST_SUB, HIST_BUCKETS - 1);
+	}
+
+	h->buckets[b]++;
+	h->count++;
+	h->max = max_t(u64, h->max, us);
+}
+
+static void sim_hist_merge(struct sim_hist *to, const struct sim_hist *from)
+{
+	unsigned int b;
+
+	for (b = 0; b < HIST_BUCKETS; b++)
+		to->buckets[b] += from->buckets[b];
+	to->count += from->count;
+	to->max = max(to->max, from->max);
+}
+
+/* The lower bound of the bucket holding the permille-th sample */
+static u64 sim_hist_pct(const struct sim_hist *h, unsigned int permille)
+{
+	u64 rank = div_u64(h->count * permille, 1000), seen = 0;
+	unsigned int b, k;
+
+	for (b = 0; b < HIST_BUCKETS; b++) {
+		seen += h->buckets[b];
+		if (seen > rank)
+			break;
+	}
+
+	if (b == HIST_BUCKETS)
+		return h->max;
+	if (b < HIST_LINEAR)
+		return b;
+
+	k = (b - HIST_LINEAR) / HIST_SUB;
+	return (u64)((b - HIST_LINEAR) % HIST_SUB + HIST_SUB) << (k + 4);
+}
+
+/* Registers 0x00 to 0x2f and the RAM from 0x40 */
+static bool sim_valid(u8 reg)
+{
+	return reg <= CTRL_RESETS || (reg >= CTRL_RAM && reg < SIM_REGS);
+}
+
+/* The address wraps from CTRL_RESETS to DT_100THS and within the RAM */
+static u8 sim_next(u8 reg)
+{
+	if (reg == CTRL_RESETS)
+		return DT_100THS;
+	if (reg == SIM_REGS - 1)
+		return CTRL_RAM;
+	return reg + 1;
+}
+
+/*
+ * The time in a register file as seconds: since the epoch, in the hour
+ * mode it is set to, or elapsed in stopwatch mode.
+ */
+static time64_t sim_regs_to_time(const u8 *regs)
+{
+	unsigned int hour = regs[DT_HOURS];
+	struct rtc_time tm;
+
+	if (regs[CTRL_FUNCTION] & FUNC_RTCM)
+		return ((time64_t)(bcd2bin(regs[SW_HR_00_XX_XX]) * 10000 +
+				   bcd2bin(regs[SW_HR_XX_00_XX]) * 100 +
+				   bcd2bin(regs[SW_HR_XX_XX_00])) * 3600 +
+			bcd2bin(regs[DT_MINUTES] & 0x7f) * 60 +
+			bcd2bin(regs[DT_SECS] & 0x7f));
+
+	if (regs[CTRL_OSCILLATOR] & OSC_12_24)
+		hour = bcd2bin(hour & 0x1f) % 12 + (hour & HOURS_PM ? 12 : 0);
+	else
+		hour = bcd2bin(hour & 0x3f);
+
+	tm = (struct rtc_time) {
+		.tm_sec = bcd2bin(regs[DT_SECS] & 0x7f),
+		.tm_min = bcd2bin(regs[DT_MINUTES] & 0x7f),
+		.tm_hour = hour,
+		.tm_mday = bcd2bin(regs[DT_DAYS] & 0x3f),
+		.tm_mon = bcd2bin(regs[DT_MONTHS] & 0x1f) - 1,
+		.tm_year = bcd2bin(regs[DT_YEARS]) + 100,
+	};
+
+	return rtc_tm_to_time64(&tm);
+}
+
+/* Bring the time registers up to the running clock */
+static void sim_latch(struct sim_chip *chip)
+{
+	u64 cs = ktime_divns(ktime_sub(ktime_get(), chip->anchor),
+			     10 * NSEC_PER_MSEC) + chip->base_hths;
+	u8 *regs = chip->regs;
+	struct rtc_time tm;
+	time64_t t;
+	u32 hths, rem, hours;
+
+	t = chip->base_sec + div_u64_rem(cs, 100, &hths);
+	regs[DT_100THS] = bin2bcd(hths);
+
+	if (regs[CTRL_FUNCTION] & FUNC_RTCM) {
+		hours = div_u64_rem(t, 3600, &rem);
+		regs[DT_SECS] = bin2bcd(rem % 60);
+		regs[DT_MINUTES] = bin2bcd(rem / 60);
+		regs[SW_HR_XX_XX_00] = bin2bcd(hours % 100);
+		regs[SW_HR_XX_00_XX] = bin2bcd(hours / 100 % 100);
+		regs[SW_HR_00_XX_XX] = bin2bcd(hours / 10000 % 100);
+		return;
+	}
+
+	rtc_time64_to_tm(t, &tm);
+
+	regs[DT_SECS] = bin2bcd(tm.tm_sec);
+	regs[DT_MINUTES] = bin2bcd(tm.tm_min);
+	if (regs[CTRL_OSCILLATOR] & OSC_12_24)
+		regs[DT_HOURS] = bin2bcd(tm.tm_hour % 12 ? : 12) |
+				 (tm.tm_hour >= 12 ? HOURS_PM : 0);
+	else
+		regs[DT_HOURS] = bin2bcd(tm.tm_hour);
+	regs[DT_DAYS] = bin2bcd(tm.tm_mday);
+	regs[DT_WEEKDAYS] = tm.tm_wday;
+	regs[DT_MONTHS] = bin2bcd(tm.tm_mon + 1);
+	regs[DT_YEARS] = bin2bcd(tm.tm_year - 100);
+}
+
+/* Count on from what the time registers hold, with the prescaler clear */
+static void sim_rebase(struct sim_chip *chip)
+{
+	chip->base_sec = sim_regs_to_time(chip->regs);
+	chip->base_hths = bcd2bin(chip->regs[DT_100THS]);
+	chip->anchor = ktime_get();
+	chip->dt_dirty = 0;
+}
+
+static void sim_write_reg(struct sim_chip *chip, u8 reg, u8 val)
+{
+	switch (reg) {
+	case DT_100THS ... DT_YEARS:
+		chip->dt_dirty |= BIT(reg);
+		break;
+	case CTRL_FLAGS:
+		/* flags clear on writing zero */
+		if ((chip->regs[reg] & FLAGS_PIF) && !(val & FLAGS_PIF))
+			sim_hist_add(&chip->irq_hist,
+				     ktime_us_delta(ktime_get(),
+						    chip->pif_raised));
+		chip->regs[reg] &= val;
+		return;
+	case CTRL_STOP_EN:
+		if ((val & STOP_EN_STOP) && !chip->stopped) {
+			sim_latch(chip);
+			chip->stopped = true;
+		} else if (!(val & STOP_EN_STOP) && chip->stopped) {
+			chip->stopped = false;
+			sim_rebase(chip);
+		}
+		break;
+	case CTRL_RESETS:
+		/* commands; the model keeps no prescaler beyond the anchor */
+		return;
+	}
+
+	chip->regs[reg] = val;
+}
+
+static int sim_write(struct sim_chip *chip, const u8 *buf, u16 len)
+{
+	bool latched = false;
+	u16 i;
+	u8 reg;
+
+	if (!len)
+		return 0;
+	if (!sim_valid(buf[0]))
+		return -EIO;
+
+	reg = buf[0];
+	for (i = 1; i < len; i++) {
+		/* a write to the running clock goes on from the current time */
+		if (reg <= DT_YEARS && !chip->stopped && !latched) {
+			sim_latch(chip);
+			latched = true;
+		}
+		sim_write_reg(chip, reg, buf[i]);
+		reg = sim_next(reg);
+	}
+	chip->ptr = reg;
+
+	if (latched && !chip->stopped)
+		sim_rebase(chip);
+
+	return 0;
+}
+
+/*
+ * The chip freezes the time registers for the length of a read, so each
+ * read message sees one instant. Any read of them while the clock is
+ * stopped, or with only some of them written since the stop, is counted.
+ */
+static int sim_read(struct sim_chip *chip, u8 *buf, u16 len)
+{
+	unsigned long dt = 0;
+	u8 reg = chip->ptr;
+	u16 i;
+
+	if (!chip->stopped)
+		sim_latch(chip);
+
+	for (i = 0; i < len; i++) {
+		if (reg <= DT_YEARS)
+			dt |= BIT(reg);
+		buf[i] = chip->regs[reg];
+		reg = sim_next(reg);
+	}
+	chip->ptr = reg;
+
+	if (dt && chip->stopped)
+		chip->stopped_reads++;
+	if (dt && chip->dt_dirty && chip->dt_dirty != DT_ALL)
+		chip->torn_reads++;
+
+	return 0;
+}
+
+/*
+ * The i2c core holds the adapter lock over the whole transfer, as on a
+ * real bus. Each message then takes as long as its bytes do at bus_khz.
+ */
+static int sim_xfer(struct i2c_adapter *adap, struct i2c_msg *msgs, int num)
+{
+	unsigned int khz = READ_ONCE(bus_khz);
+	struct sim_chip *chip;
+	unsigned long flags, us;
+	int i, ret;
+
+	for (i = 0; i < num; i++) {
+		if (msgs[i].addr < SIM_ADDR ||
+		    msgs[i].addr >= SIM_ADDR + SIM_CHIPS)
+			return -ENXIO;
+		chip = &sim.chips[msgs[i].addr - SIM_ADDR];
+
+		spin_lock_irqsave(&chip->lock, flags);
+		if (msgs[i].flags & I2C_M_RD)
+			ret = sim_read(chip, msgs[i].buf, msgs[i].len);
+		else
+			ret = sim_write(chip, msgs[i].buf, msgs[i].len);
+		spin_unlock_irqrestore(&chip->lock, flags);
+		if (ret)
+			return ret;
+
+		/* address and data bytes, 9 clocks each */
+		if (khz) {
+			us = (msgs[i].len + 1) * 9000 / khz;
+			usleep_range(us, us + us / 8 + 1);
+		}
+	}
+
+	return num;
+}
+
+static u32 sim_functionality(struct i2c_adapter *adap)
+{
+	return I2C_FUNC_I2C;
+}
+
+static const struct i2c_algorithm sim_algo = {
+	.master_xfer	= sim_xfer,
+	.functionality	= sim_functionality,
+};
+
+#ifdef CONFIG_IRQ_SIM
+/* Raise PIF and INTA with it, whatever the driver has enabled */
+static enum hrtimer_restart sim_tick(struct hrtimer *timer)
+{
+	struct sim_chip *chip = &sim.chips[0];
+	bool fire = false;
+
+	spin_lock(&chip->lock);
+	if (chip->regs[CTRL_FLAGS] & FLAGS_PIF) {
+		chip->missed_irqs++;
+	} else {
+		chip->regs[CTRL_FLAGS] |= FLAGS_PIF;
+		chip->pif_raised = ktime_get();
+		chip->irqs++;
+		fire = true;
+	}
+	spin_unlock(&chip->lock);
+
+	if (fire)
+		irq_sim_fire(&sim.irq_sim, 0);
+
+	hrtimer_forward_now(timer, sim.period);
+
+	return HRTIMER_RESTART;
+}
+#endif
+
+static bool sim_within(time64_t t, time64_t before, time64_t after)
+{
+	return t >= before - SIM_TOLERANCE && t <= after + SIM_TOLERANCE;
+}
+
+/* A read has to give the system time, or the system time moved by a set */
+static bool sim_time_ok(time64_t t, time64_t before, time64_t after)
+{
+	return sim_within(t, before, after) ||
+	       sim_within(t - SIM_SHIFT, before, after);
+}
+
+/*
+ * Whether chip 0 may have left rtc mode since seq was read: its time is
+ * then the stopwatch, or the epoch until the mode thread sets it again,
+ * and reads, sets and the group fail on it as they should.
+ */
+static bool sim_mode_moved(int seq)
+{
+	return (seq & 1) || atomic_read(&sim.mode_seq) != seq;
+}
+
+/* Set the system time, moved by SIM_SHIFT every other set */
+static int sim_set_time(struct rtc_device *rtc)
+{
+	time64_t t = ktime_get_real_seconds();
+	struct rtc_time tm;
+
+	if (atomic_inc_return(&sim.set_seq) & 1)
+		t += SIM_SHIFT;
+	rtc_time64_to_tm(t, &tm);
+
+	return rtc_set_time(rtc, &tm);
+}
+
+static void sim_pause(void)
+{
+	unsigned long interval = msecs_to_jiffies(sim.run_set_interval_ms);
+
+	if (interval)
+		schedule_timeout_interruptible(interval);
+	else
+		cond_resched();
+}
+
+static int sim_reader(void *data)
+{
+	struct sim_worker *w = data;
+	time64_t before, after;
+	struct rtc_time tm;
+	ktime_t start;
+	int ret, seq;
+
+	while (!kthread_should_stop()) {
+		seq = atomic_read(&sim.mode_seq);
+		before = ktime_get_real_seconds();
+		start = ktime_get();
+		ret = rtc_read_time(w->rtc, &tm);
+		sim_hist_add(&w->hist, ktime_us_delta(ktime_get(), start));
+		after = ktime_get_real_seconds();
+		w->ops++;
+
+		if (!sim_mode_moved(seq)) {
+			if (ret)
+				w->errors++;
+			else if (!sim_time_ok(rtc_tm_to_time64(&tm), before,
+					      after))
+				w->bad++;
+		}
+
+		cond_resched();
+	}
+
+	return 0;
+}
+
+static int sim_setter(void *data)
+{
+	struct sim_worker *w = data;
+	ktime_t start;
+	int ret, seq;
+
+	while (!kthread_should_stop()) {
+		seq = atomic_read(&sim.mode_seq);
+		start = ktime_get();
+		ret = sim_set_time(w->rtc);
+		sim_hist_add(&w->hist, ktime_us_delta(ktime_get(), start));
+		w->ops++;
+
+		if (ret && !sim_mode_moved(seq))
+			w->errors++;
+
+		sim_pause();
+	}
+
+	return 0;
+}
+
+/* The group stops, writes and starts both chips under their own locks */
+static int sim_group(void *data)
+{
+	struct sim_worker *w = data;
+	time64_t before, after;
+	struct rtc_time tm;
+	int ret, seq;
+
+	while (!kthread_should_stop()) {
+		seq = atomic_read(&sim.mode_seq);
+		ret = sim_set_time(w->rtc);
+		if (ret && !sim_mode_moved(seq))
+			w->errors++;
+
+		before = ktime_get_real_seconds();
+		ret = rtc_read_time(w->rtc, &tm);
+		after = ktime_get_real_seconds();
+		w->ops += 2;
+
+		if (!sim_mode_moved(seq)) {
+			if (ret)
+				w->errors++;
+			else if (!sim_time_ok(rtc_tm_to_time64(&tm), before,
+					      after))
+				w->bad++;
+		}
+
+		sim_pause();
+	}
+
+	return 0;
+}
+
+/* A sysfs store, as from userspace: one write from the start */
+static int sim_attr_write(struct file *file, const char *s)
+{
+	loff_t pos = 0;
+	ssize_t ret;
+
+	ret = kernel_write(file, s, strlen(s), &pos);
+
+	return ret < 0 ? ret : 0;
+}
+
+static ssize_t sim_attr_read(struct file *file, void *buf, size_t len)
+{
+	loff_t pos = 0;
+
+	return kernel_read(file, buf, len, &pos);
+}
+
+/* A preset has to read back as itself, plus the time since */
+static int sim_stopwatch_check(struct sim_worker *w)
+{
+	char buf[24];
+	ssize_t len;
+	u64 hths;
+	int ret;
+
+	ret = sim_attr_write(sim.stopwatch_file,
+			     __stringify(SIM_STOPWATCH) "\n");
+	if (ret)
+		return ret;
+
+	len = sim_attr_read(sim.stopwatch_file, buf, sizeof(buf) - 1);
+	if (len < 0)
+		return len;
+	buf[len] = '\0';
+
+	ret = kstrtou64(buf, 10, &hths);
+	if (ret)
+		return ret;
+
+	if (hths < SIM_STOPWATCH || hths > SIM_STOPWATCH + SIM_TOLERANCE * 100)
+		w->bad++;
+
+	return 0;
+}
+
+/*
+ * Chip 0 through stopwatch mode and back: switch, preset and read the
+ * counter, switch back and set the time. The sysfs stores take the driver
+ * lock but not the rtc core's, so they race everything else in the run.
+ */
+static int sim_mode(void *data)
+{
+	struct sim_worker *w = data;
+
+	while (!kthread_should_stop()) {
+		atomic_inc(&sim.mode_seq);
+
+		if (sim_attr_write(sim.mode_file, "stopwatch") ||
+		    sim_stopwatch_check(w))
+			w->errors++;
+		if (sim_attr_write(sim.mode_file, "rtc") ||
+		    sim_set_time(w->rtc))
+			w->errors++;
+
+		atomic_inc(&sim.mode_seq);
+		w->ops++;
+
+		sim_pause();
+	}
+
+	return 0;
+}
+
+/* The dump has to hold the time at its own timestamp */
+static int sim_dump(void *data)
+{
+	struct sim_worker *w = data;
+	u8 dump[SIM_DUMP_LEN];
+	ktime_t start;
+	ssize_t len;
+	time64_t t;
+	int seq;
+
+	while (!kthread_should_stop()) {
+		seq = atomic_read(&sim.mode_seq);
+		start = ktime_get();
+		len = sim_attr_read(sim.regs_file, dump, sizeof(dump));
+		sim_hist_add(&w->hist, ktime_us_delta(ktime_get(), start));
+		w->ops++;
+
+		if (len != sizeof(dump)) {
+			w->errors++;
+		} else if (!sim_mode_moved(seq)) {
+			t = div_u64(get_unaligned_le64(dump + SIM_DUMP_TIMESTAMP),
+				    NSEC_PER_SEC);
+			if (!sim_time_ok(sim_regs_to_time(dump + SIM_DUMP_HDR),
+					 t, t))
+				w->bad++;
+		}
+
+		cond_resched();
+	}
+
+	return 0;
+}
+
+/*
+ * Each store of the interval runs the page refresh at once, from a work
+ * item calling the driver's read_time directly.
+ */
+static int sim_page(void *data)
+{
+	struct sim_worker *w = data;
+
+	while (!kthread_should_stop()) {
+		if (sim_attr_write(sim.page_file, __stringify(SIM_PAGE_MS)))
+			w->errors++;
+		w->ops++;
+
+		usleep_range(1000, 2000);
+	}
+
+	return 0;
+}
+
+static int (* const sim_fns[SIM_KINDS])(void *) = {
+	[SIM_READER]	= sim_reader,
+	[SIM_SETTER]	= sim_setter,
+	[SIM_GROUP]	= sim_group,
+	[SIM_MODE]	= sim_mode,
+	[SIM_DUMP]	= sim_dump,
+	[SIM_PAGE]	= sim_page,
+};
+
+static void sim_reset_stats(struct sim_chip *chip)
+{
+	unsigned long flags;
+
+	spin_lock_irqsave(&chip->lock, flags);
+	chip->stopped_reads = 0;
+	chip->torn_reads = 0;
+	chip->irqs = 0;
+	chip->missed_irqs = 0;
+	memset(&chip->irq_hist, 0, sizeof(chip->irq_hist));
+	spin_unlock_irqrestore(&chip->lock, flags);
+}
+
+static void sim_collect(struct sim_worker *w, unsigned int n,
+			struct sim_hist *hist, struct sim_step *step)
+{
+	struct sim_chip *chip;
+	unsigned long flags;
+	unsigned int i;
+
+	memset(hist, 0, sizeof(*hist));
+	for (i = 0; i < n; i++) {
+		step->errors += w[i].errors;
+
+		switch (w[i].kind) {
+		case SIM_READER:
+			sim_hist_merge(hist, &w[i].hist);
+			step->readers++;
+			step->reads += w[i].ops;
+			step->bad_reads += w[i].bad;
+			break;
+		case SIM_SETTER:
+			step->sets += w[i].ops;
+			break;
+		case SIM_GROUP:
+			step->group_ops += w[i].ops;
+			step->group_bad += w[i].bad;
+			break;
+		case SIM_MODE:
+			step->mode_cycles += w[i].ops;
+			step->stopwatch_bad += w[i].bad;
+			break;
+		case SIM_DUMP:
+			step->dumps += w[i].ops;
+			step->dump_bad += w[i].bad;
+			break;
+		case SIM_PAGE:
+			step->page_kicks += w[i].ops;
+			break;
+		default:
+			break;
+		}
+	}
+	step->read_p50 = sim_hist_pct(hist, 500);
+	step->read_p99 = sim_hist_pct(hist, 990);
+	step->read_p999 = sim_hist_pct(hist, 999);
+	step->read_max = hist->max;
+
+	memset(hist, 0, sizeof(*hist));
+	for (i = 0; i < n; i++)
+		if (w[i].kind == SIM_SETTER)
+			sim_hist_merge(hist, &w[i].hist);
+	step->set_p99 = sim_hist_pct(hist, 990);
+	step->set_max = hist->max;
+
+	for (i = 0; i < SIM_CHIPS; i++) {
+		chip = &sim.chips[i];
+
+		spin_lock_irqsave(&chip->lock, flags);
+		if (!i) {
+			step->irqs = chip->irqs;
+			step->missed_irqs = chip->missed_irqs;
+			step->irq_p99 = sim_hist_pct(&chip->irq_hist, 990);
+			step->irq_max = chip->irq_hist.max;
+		}
+		step->stopped_reads += chip->stopped_reads;
+		step->torn_reads += chip->torn_reads;
+		spin_unlock_irqrestore(&chip->lock, flags);
+	}
+}
+
+static int sim_run_step(struct rtc_device *rtc, unsigned int nreaders,
+			struct sim_step *step)
+{
+	unsigned int count[SIM_KINDS] = {
+		[SIM_READER]	= nreaders,
+		[SIM_SETTER]	= sim.run_setters,
+		[SIM_GROUP]	= sim.group_rtc ? 1 : 0,
+		[SIM_MODE]	= sim.mode_file && sim.stopwatch_file ? 1 : 0,
+		[SIM_DUMP]	= sim.regs_file ? 1 : 0,
+		[SIM_PAGE]	= sim.page_file ? 1 : 0,
+	};
+	unsigned int i, j, kind, n = 0;
+	struct sim_worker *w;
+	struct sim_hist *hist;
+	int ret = 0;
+
+	for (kind = 0; kind < SIM_KINDS; kind++)
+		n += count[kind];
+
+	w = vzalloc(array_size(n, sizeof(*w)));
+	hist = vzalloc(sizeof(*hist));
+	if (!w || !hist) {
+		ret = -ENOMEM;
+		goto out;
+	}
+
+	for (kind = 0, i = 0; kind < SIM_KINDS; kind++) {
+		for (j = 0; j < count[kind]; j++, i++) {
+			w[i].kind = kind;
+			w[i].rtc = kind == SIM_GROUP ? sim.group_rtc : rtc;
+		}
+	}
+
+	for (i = 0; i < SIM_CHIPS; i++)
+		sim_reset_stats(&sim.chips[i]);
+
+	for (i = 0; i < n; i++) {
+		struct task_struct *task;
+
+		task = kthread_run(sim_fns[w[i].kind], &w[i],
+				   "pcf85263-sim/%u", i);
+		if (IS_ERR(task)) {
+			ret = PTR_ERR(task);
+			break;
+		}
+		w[i].task = task;
+	}
+
+#ifdef CONFIG_IRQ_SIM
+	if (!ret && sim.run_irq_hz)
+		hrtimer_start(&sim.timer, sim.period, HRTIMER_MODE_REL);
+#endif
+
+	if (!ret && msleep_interruptible(sim.run_duration_ms))
+		ret = -EINTR;
+
+#ifdef CONFIG_IRQ_SIM
+	hrtimer_cancel(&sim.timer);
+#endif
+
+	for (i = 0; i < n; i++)
+		if (w[i].task)
+			kthread_stop(w[i].task);
+
+	if (!ret)
+		sim_collect(w, n, hist, step);
+out:
+	vfree(hist);
+	vfree(w);
+
+	return ret;
+}
+
+static int sim_match_rtc(struct device *dev, void *data)
+{
+	return dev->class && !strcmp(dev->class->name, "rtc");
+}
+
+/* The rtc a driver registered under parent, with a reference */
+static struct rtc_device *sim_open_rtc(struct device *parent)
+{
+	struct rtc_device *rtc;
+	struct device *dev;
+
+	dev = device_find_child(parent, NULL, sim_match_rtc);
+	if (!dev)
+		return ERR_PTR(-ENODEV);
+
+	rtc = rtc_class_open(dev_name(dev));
+	put_device(dev);
+
+	return rtc ? rtc : ERR_PTR(-ENODEV);
+}
+
+#ifdef CONFIG_OF_DYNAMIC
+/*
+ * Device tree nodes for the two chips and their group, under a node of
+ * their own that the platform bus leaves alone: chip 0 with the time
+ * page, chip 1 asking for 24-hour mode, so the driver normalizes it.
+ */
+static void sim_prop(struct sim_node *n, const char *name,
+		     const void *value, int length)
+{
+	struct property *prop = &n->props[n->nprops++];
+
+	prop->name = (char *)name;
+	prop->value = (void *)value;
+	prop->length = length;
+	prop->next = n->np.properties;
+	n->np.properties = prop;
+}
+
+static void sim_node_init(struct sim_node *n, struct device_node *parent,
+			  const char *name)
+{
+	of_node_init(&n->np);
+	of_node_set_flag(&n->np, OF_DETACHED);
+	strlcpy(n->full_name, name, sizeof(n->full_name));
+	n->np.full_name = n->full_name;
+	n->np.parent = parent;
+	sim_prop(n, "name", name, strlen(name) + 1);
+}
+
+static int sim_of_init(void)
+{
+	struct sim_node *rtc;
+	unsigned int i;
+	int ret;
+
+	if (!of_root)
+		return 0;
+
+	sim_node_init(&sim.bus, of_root, "pcf85263-sim");
+	of_node_set_flag(&sim.bus.np, OF_POPULATED);
+
+	for (i = 0; i < SIM_CHIPS; i++) {
+		rtc = &sim.rtcs[i];
+		sim_node_init(rtc, &sim.bus.np, "rtc");
+		snprintf(rtc->full_name, sizeof(rtc->full_name), "rtc@%x",
+			 SIM_ADDR + i);
+		sim_prop(rtc, "compatible", "nxp,pcf85263",
+			 sizeof("nxp,pcf85263"));
+		sim.phandles[i] = cpu_to_be32(SIM_PHANDLE + i);
+		sim_prop(rtc, "phandle", &sim.phandles[i],
+			 sizeof(sim.phandles[i]));
+	}
+
+	sim.page_ms = cpu_to_be32(SIM_PAGE_MS);
+	sim_prop(&sim.rtcs[0], "nxp,time-page", NULL, 0);
+	sim_prop(&sim.rtcs[0], "nxp,time-page-interval-ms", &sim.page_ms,
+		 sizeof(sim.page_ms));
+	sim_prop(&sim.rtcs[1], "nxp,24-hour-mode", NULL, 0);
+
+	sim_node_init(&sim.group, &sim.bus.np, "rtc-group");
+	sim_prop(&sim.group, "compatible", "nxp,pcf85263-group",
+		 sizeof("nxp,pcf85263-group"));
+	sim_prop(&sim.group, "nxp,rtcs", sim.phandles, sizeof(sim.phandles));
+
+	of_changeset_init(&sim.changeset);
+	ret = of_changeset_attach_node(&sim.changeset, &sim.bus.np);
+	for (i = 0; !ret && i < SIM_CHIPS; i++)
+		ret = of_changeset_attach_node(&sim.changeset,
+					       &sim.rtcs[i].np);
+	if (!ret)
+		ret = of_changeset_attach_node(&sim.changeset, &sim.group.np);
+	if (!ret)
+		ret = of_changeset_apply(&sim.changeset);
+	if (ret) {
+		of_changeset_destroy(&sim.changeset);
+		return ret;
+	}
+
+	sim.applied = true;
+
+	return 0;
+}
+
+static struct device_node *sim_of_node(unsigned int chip)
+{
+	return sim.applied ? &sim.rtcs[chip].np : NULL;
+}
+
+/* Binds once both chips have, deferring until then */
+static int sim_of_group_add(void)
+{
+	if (!sim.applied)
+		return 0;
+
+	sim.group_pdev = of_platform_device_create(&sim.group.np, NULL, NULL);
+
+	return sim.group_pdev ? 0 : -ENODEV;
+}
+
+static void sim_of_group_del(void)
+{
+	if (sim.group_pdev)
+		of_platform_device_destroy(&sim.group_pdev->dev, NULL);
+}
+
+static struct device *sim_of_group(void)
+{
+	return sim.group_pdev ? &sim.group_pdev->dev : NULL;
+}
+
+static void sim_of_fini(void)
+{
+	if (!sim.applied)
+		return;
+
+	of_changeset_revert(&sim.changeset);
+	of_changeset_destroy(&sim.changeset);
+}
+#else
+static int sim_of_init(void)
+{
+	return 0;
+}
+
+static struct device_node *sim_of_node(unsigned int chip)
+{
+	return NULL;
+}
+
+static int sim_of_group_add(void)
+{
+	return 0;
+}
+
+static void sim_of_group_del(void)
+{
+}
+
+static struct device *sim_of_group(void)
+{
+	return NULL;
+}
+
+static void sim_of_fini(void)
+{
+}
+#endif
+
+/*
+ * Chip 1 starts in 12-hour mode and its node asks for 24-hour mode, so
+ * probe has re-encoded it by the first run: in 24-hour mode, on time, and
+ * without a read of the time registers while it was at it.
+ */
+static void sim_check_normalize(void)
+{
+	struct sim_chip *chip = &sim.chips[1];
+	time64_t now = ktime_get_real_seconds();
+	unsigned long flags;
+
+	if (!sim_of_node(1) || sim.normalized >= 0)
+		return;
+
+	spin_lock_irqsave(&chip->lock, flags);
+	if (!chip->stopped)
+		sim_latch(chip);
+	sim.normalized = sim.clients[1]->dev.driver &&
+			 !(chip->regs[CTRL_OSCILLATOR] & OSC_12_24) &&
+			 !chip->stopped && !chip->stopped_reads &&
+			 !chip->torn_reads &&
+			 sim_within(sim_regs_to_time(chip->regs), now, now);
+	spin_unlock_irqrestore(&chip->lock, flags);
+}
+
+/* An attribute of chip 0, or NULL to leave its thread out */
+static struct file *sim_open_attr(const char *attr, int flags)
+{
+	struct device *dev = &sim.clients[0]->dev;
+	struct file *file;
+	char path[64];
+
+	snprintf(path, sizeof(path), "/sys/bus/i2c/devices/%s/%s",
+		 dev_name(dev), attr);
+	file = filp_open(path, flags, 0);
+	if (IS_ERR(file)) {
+		dev_warn(dev, "no %s, left out: %ld\n", attr, PTR_ERR(file));
+		return NULL;
+	}
+
+	return file;
+}
+
+static void sim_close_attr(struct file **file)
+{
+	if (*file)
+		filp_close(*file, NULL);
+	*file = NULL;
+}
+
+static void sim_open_bypass(void)
+{
+	struct device *group = sim_of_group();
+	struct rtc_device *rtc;
+
+	sim.mode_file = sim_open_attr("mode", O_RDWR);
+	sim.stopwatch_file = sim_open_attr("stopwatch", O_RDWR);
+	sim.regs_file = sim_open_attr("registers", O_RDONLY);
+
+	if (!sim_of_node(0))
+		return;
+
+	sim.page_file = sim_open_attr("time_page_interval_ms", O_WRONLY);
+
+	rtc = group ? sim_open_rtc(group) : ERR_PTR(-ENODEV);
+	if (IS_ERR(rtc))
+		dev_warn(&sim.clients[0]->dev, "the group is not bound\n");
+	else
+		sim.group_rtc = rtc;
+}
+
+static void sim_close_bypass(void)
+{
+	sim_close_attr(&sim.mode_file);
+	sim_close_attr(&sim.stopwatch_file);
+	sim_close_attr(&sim.regs_file);
+	sim_close_attr(&sim.page_file);
+
+	if (sim.group_rtc)
+		rtc_class_close(sim.group_rtc);
+	sim.group_rtc = NULL;
+}
+
+static int sim_run(void)
+{
+	unsigned int n, max = clamp_t(unsigned int, readers, 1,
+				      SIM_MAX_READERS);
+	struct rtc_device *rtc;
+	struct sim_step *step;
+	int ret = 0;
+
+	rtc = sim_open_rtc(&sim.clients[0]->dev);
+	if (IS_ERR(rtc)) {
+		dev_err(&sim.clients[0]->dev, "rtc-pcf85263 is not bound\n");
+		return PTR_ERR(rtc);
+	}
+
+	sim_check_normalize();
+
+	sim.nsteps = 0;
+	sim.run_setters = min_t(unsigned int, setters, SIM_MAX_SETTERS);
+	sim.run_set_interval_ms = set_interval_ms;
+	sim.run_duration_ms = max_t(unsigned int, duration_ms,
+				    SIM_MIN_DURATION_MS);
+	sim.run_bus_khz = bus_khz;
+	sim.run_bypass = bypass;
+#ifdef CONFIG_IRQ_SIM
+	sim.run_irq_hz = min_t(unsigned int, irq_hz, SIM_MAX_IRQ_HZ);
+	if (sim.run_irq_hz)
+		sim.period = ns_to_ktime(div_u64(NSEC_PER_SEC,
+						 sim.run_irq_hz));
+#else
+	sim.run_irq_hz = 0;
+#endif
+
+	if (sim.run_bypass)
+		sim_open_bypass();
+
+	for (n = 1; n <= max; n *= 2) {
+		step = &sim.steps[sim.nsteps];
+		memset(step, 0, sizeof(*step));
+
+		ret = sim_run_step(rtc, n, step);
+		if (ret)
+			break;
+		sim.nsteps++;
+
+		dev_info(&sim.clients[0]->dev,
+			 "%u readers: %llu reads, p99 %llu us, %llu sets, %lu irqs, %lu group, %lu mode, %lu dumps, %lu stopped, %lu torn, %lu bad, %lu errors\n",
+			 n, step->reads, step->read_p99, step->sets,
+			 step->irqs, step->group_ops, step->mode_cycles,
+			 step->dumps, step->stopped_reads, step->torn_reads,
+			 step->bad_reads + step->group_bad +
+			 step->stopwatch_bad + step->dump_bad, step->errors);
+	}
+
+	sim_close_bypass();
+	rtc_class_close(rtc);
+
+	return ret;
+}
+
+static ssize_t sim_run_write(struct file *file, const char __user *buf,
+			     size_t count, loff_t *ppos)
+{
+	int ret;
+
+	ret = mutex_lock_interruptible(&sim.run_lock);
+	if (ret)
+		return ret;
+
+	ret = sim_run();
+	mutex_unlock(&sim.run_lock);
+
+	return ret ? ret : count;
+}
+
+static const struct file_operations sim_run_fops = {
+	.owner	= THIS_MODULE,
+	.open	= simple_open,
+	.write	= sim_run_write,
+	.llseek	= no_llseek,
+};
+
+static const char * const sim_normalized[] = { "null", "false", "true" };
+
+/* In the layout of pcf85263bench, so the two compare side by side */
+static int sim_results_show(struct seq_file *s, void *unused)
+{
+	unsigned long violations = 0;
+	struct sim_step *step;
+	unsigned int i;
+
+	mutex_lock(&sim.run_lock);
+
+	seq_printf(s,
+		   "{\n  \"bus_khz\": %u,\n  \"setters\": %u,\n"
+		   "  \"set_interval_ms\": %u,\n  \"irq_hz\": %u,\n"
+		   "  \"duration_ms\": %u,\n  \"bypass\": %s,\n"
+		   "  \"normalized\": %s,\n  \"steps\": [\n",
+		   sim.run_bus_khz, sim.run_setters, sim.run_set_interval_ms,
+		   sim.run_irq_hz, sim.run_duration_ms,
+		   sim.run_bypass ? "true" : "false",
+		   sim_normalized[sim.normalized + 1]);
+
+	for (i = 0; i < sim.nsteps; i++) {
+		step = &sim.steps[i];
+		seq_printf(s,
+			   "    { \"readers\": %u, \"reads_per_sec\": %llu, "
+			   "\"read_p50_us\": %llu, \"read_p99_us\": %llu, "
+			   "\"read_p999_us\": %llu, \"read_max_us\": %llu, "
+			   "\"sets\": %llu, \"set_p99_us\": %llu, "
+			   "\"set_max_us\": %llu, \"irqs\": %lu, "
+			   "\"missed_irqs\": %lu, \"irq_p99_us\": %llu, "
+			   "\"irq_max_us\": %llu, \"group_ops\": %lu, "
+			   "\"mode_cycles\": %lu, \"dumps\": %lu, "
+			   "\"page_kicks\": %lu, \"errors\": %lu, "
+			   "\"stopped_reads\": %lu, \"torn_reads\": %lu, "
+			   "\"bad_reads\": %lu, \"group_bad\": %lu, "
+			   "\"stopwatch_bad\": %lu, \"dump_bad\": %lu }%s\n",
+			   step->readers,
+			   div_u64(step->reads * 1000, sim.run_duration_ms),
+			   step->read_p50, step->read_p99, step->read_p999,
+			   step->read_max, step->sets, step->set_p99,
+			   step->set_max, step->irqs, step->missed_irqs,
+			   step->irq_p99, step->irq_max, step->group_ops,
+			   step->mode_cycles, step->dumps, step->page_kicks,
+			   step->errors, step->stopped_reads,
+			   step->torn_reads, step->bad_reads, step->group_bad,
+			   step->stopwatch_bad, step->dump_bad,
+			   i + 1 < sim.nsteps ? "," : "");
+		violations += step->errors + step->stopped_reads +
+			      step->torn_reads + step->bad_reads +
+			      step->group_bad + step->stopwatch_bad +
+			      step->dump_bad;
+	}
+
+	if (!sim.normalized)
+		violations++;
+
+	seq_printf(s, "  ],\n  \"violations\": %lu\n}\n", violations);
+
+	mutex_unlock(&sim.run_lock);
+
+	return 0;
+}
+
+DEFINE_SHOW_ATTRIBUTE(sim_results);
+
+static int __init pcf85263_sim_init(void)
+{
+	struct i2c_board_info info;
+	unsigned int i;
+	int ret;
+
+	mutex_init(&sim.run_lock);
+	sim.normalized = -1;
+
+	/* running from the system time, chip 1 left in 12-hour mode */
+	for (i = 0; i < SIM_CHIPS; i++) {
+		spin_lock_init(&sim.chips[i].lock);
+		sim.chips[i].base_sec = ktime_get_real_seconds();
+		sim.chips[i].anchor = ktime_get();
+	}
+	sim.chips[1].regs[CTRL_OSCILLATOR] = OSC_12_24;
+
+#ifdef CONFIG_IRQ_SIM
+	ret = irq_sim_init(&sim.irq_sim, 1);
+	if (ret < 0)
+		return ret;
+
+	hrtimer_init(&sim.timer, CLOCK_MONOTONIC, HRTIMER_MODE_REL);
+	sim.timer.function = sim_tick;
+#endif
+
+	sim.adap.owner = THIS_MODULE;
+	sim.adap.algo = &sim_algo;
+	strlcpy(sim.adap.name, "pcf85263-sim", sizeof(sim.adap.name));
+
+	ret = i2c_add_adapter(&sim.adap);
+	if (ret)
+		goto err_irq;
+
+	ret = sim_of_init();
+	if (ret)
+		goto err_adap;
+
+	for (i = 0; i < SIM_CHIPS; i++) {
+		info = (struct i2c_board_info) {
+			I2C_BOARD_INFO("pcf85263", SIM_ADDR + i),
+		};
+		info.of_node = sim_of_node(i);
+#ifdef CONFIG_IRQ_SIM
+		if (!i)
+			info.irq = irq_sim_irqnum(&sim.irq_sim, 0);
+#endif
+
+		sim.clients[i] = i2c_new_device(&sim.adap, &info);
+		if (!sim.clients[i]) {
+			ret = -ENODEV;
+			goto err_clients;
+		}
+	}
+
+	ret = sim_of_group_add();
+	if (ret)
+		goto err_clients;
+
+	sim.dir = debugfs_create_dir("pcf85263-sim", NULL);
+	debugfs_create_file("run", 0200, sim.dir, NULL, &sim_run_fops);
+	debugfs_create_file("results", 0444, sim.dir, NULL,
+			    &sim_results_fops);
+
+	return 0;
+
+err_clients:
+	while (i--)
+		i2c_unregister_device(sim.clients[i]);
+	sim_of_fini();
+err_adap:
+	i2c_del_adapter(&sim.adap);
+err_irq:
+#ifdef CONFIG_IRQ_SIM
+	irq_sim_fini(&sim.irq_sim);
+#endif
+	return ret;
+}
+module_init(pcf85263_sim_init);
+
+static void __exit pcf85263_sim_exit(void)
+{
+	unsigned int i = SIM_CHIPS;
+
+	debugfs_remove_recursive(sim.dir);
+	sim_of_group_del();
+	while (i--)
+		i2c_unregister_device(sim.clients[i]);
+	sim_of_fini();
+	i2c_del_adapter(&sim.adap);
+#ifdef CONFIG_IRQ_SIM
+	irq_sim_fini(&sim.irq_sim);
+#endif
+}
+module_exit(pcf85263_sim_exit);
+
+MODULE_AUTHOR("Alan Morris");
+MODULE_DESCRIPTION("simulated PCF85263 and stress test for rtc-pcf85263");
+MODULE_LICENSE("GPL");
@@ -0,0 +1,55 @@
+/*
+ * Trace events for rtc-pcf85263. The boot timing marks carry the chip time
+ * of each phase, so a trace lines them up with the kernel's own events:
+ *
+ *	# echo 1 > /sys/kernel/debug/tracing/events/pcf85263/enable
+ *
+ * or trace_event=pcf85263 on the command line to catch the probe marks.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ */
+#undef TRACE_SYSTEM
+#define TRACE_SYSTEM pcf85263
+
+#if !defined(PCF85263_TRACE_H) || defined(TRACE_HEADER_MULTI_READ)
+#define PCF85263_TRACE_H
+
+#include <linux/device.h>
+#include <linux/time64.h>
+#include <linux/tracepoint.h>
+
+/* mark is one of shutdown, power_on, probe and ready */
+TRACE_EVENT(pcf85263_boot_mark,
+	TP_PROTO(struct device *dev, const char *mark,
+		 const struct timespec64 *ts),
+
+	TP_ARGS(dev, mark, ts),
+
+	TP_STRUCT__entry(
+		__string(dev, dev_name(dev))
+		__string(mark, mark)
+		__field(s64, sec)
+		__field(long, nsec)
+	),
+
+	TP_fast_assign(
+		__assign_str(dev, dev_name(dev));
+		__assign_str(mark, mark);
+		__entry->sec = ts->tv_sec;
+		__entry->nsec = ts->tv_nsec;
+	),
+
+	TP_printk("%s %s %lld.%02ld", __get_str(dev), __get_str(mark),
+		  __entry->sec, __entry->nsec / (10 * NSEC_PER_MSEC))
+);
+
+#endif /* PCF85263_TRACE_H */
+
+/* built out of tree, the header is found through -I$(src) */
+#undef TRACE_INCLUDE_PATH
+#define TRACE_INCLUDE_PATH .
+#undef TRACE_INCLUDE_FILE
+#define TRACE_INCLUDE_FILE pcf85263-trace
+#include <trace/define_trace.h>
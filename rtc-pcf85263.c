@@ -1,5 +1,5 @@
 /*
- * Driver for NXP PCF85263 real-time clock.
+ * Driver for NXP PCF85263, PCF85363 and PCF85063 real-time clocks.
  *
  * This program is free software; you can redistribute it and/or modify
  * it under the terms of the GNU General Public License version 2 as
@@ -7,7 +7,7 @@
  *
  * Based on the rtc-pcf85363 rtc driver by Eric Nelson.
  * Back-ported/written for kernel version 4.9.78-ti-r94 on 2023-12-18
- * Not tested on PCF85363.
+ * Not tested on PCF85363 or the PCF85063 family.
  */
 #include <linux/module.h>
 #include <linux/i2c.h>
@@ -19,118 +19,423 @@
 #include <linux/bcd.h>
 #include <linux/of.h>
 #include <linux/of_device.h>
+#include <linux/of_irq.h>
+#include <linux/platform_device.h>
+#include <linux/property.h>
 #include <linux/regmap.h>
+#include <linux/nvmem-provider.h>
+#include <linux/clk-provider.h>
+#include <linux/interrupt.h>
+#include <linux/mutex.h>
+#include <linux/iio/iio.h>
+#include <linux/iio/trigger.h>
+#include <linux/pps_kernel.h>
+#include <linux/timekeeping.h>
+#include <linux/math64.h>
+#include <linux/workqueue.h>
+#include <linux/sort.h>
+#include <linux/miscdevice.h>
+#include <linux/mm.h>
+#include <linux/fs.h>
+#include <linux/spinlock.h>
+#include <linux/thermal.h>
+
+#include "pcf85263-regs.h"
+#include "pcf85263-page.h"
+
+#define CREATE_TRACE_POINTS
+#include "pcf85263-trace.h"
+
+/*
+ * Variant feature bits
+ */
+#define PCF_FEAT_100THS		BIT(0)
+#define PCF_FEAT_ALARM1		BIT(1)
+#define PCF_FEAT_ALARM2		BIT(2)
+#define PCF_FEAT_TIMESTAMPS	BIT(3)
+#define PCF_FEAT_STOPWATCH	BIT(4)
+#define PCF_FEAT_INTAB		BIT(5)	/* INTA/INTB, CTRL_PIN_IO, periodic */
+
+/*
+ * Driver metadata kept at the top of the PCF85363 RAM
+ */
+#define META_SIZE	0x20
+#define META_OFFSET	(RAM_SIZE - META_SIZE)
+#define META_MAGIC	0x63
+#define META_VERSION	1
+
+#define DRIFT_MIN_SPAN	(24 * 3600)
+#define DRIFT_MAX_PPB	200000
+
+#define ALIGN_TRIES	64
+
+#define PAGE_INTERVAL_MS	60000
+#define PAGE_INTERVAL_MIN	10
+
+/*
+ * CTRL_OFFSET step with OFFM set, and the temperature compensation defaults
+ * for a 32.768 kHz tuning fork crystal
+ */
+#define OFFSET_LSB_PPB		2170
+#define TC_INTERVAL_MS		60000
+#define TC_INTERVAL_MIN		1000
+#define TC_MIN_WRITE_MS		(8 * 60 * 1000)	/* one OFFM correction period */
+#define TC_TURNOVER		25000		/* millicelsius */
+#define TC_COEFF		34		/* ppb per degree squared */
+#define TC_COEFF_MAX		1000
+#define TC_DT_MAX		200000		/* millicelsius */
+
+/*
+ * Sleep time injection uses timekeeping hooks that 4.19 keeps for the
+ * built-in rtc core and does not export, so a module leaves suspend time
+ * to the core's whole-second accounting.
+ */
+#if defined(CONFIG_PM_SLEEP) && defined(CONFIG_RTC_HCTOSYS_DEVICE) && \
+	!defined(MODULE)
+#define PCF85263_SLEEPTIME
+#endif
+
+/* CTRL_OSCILLATOR through CTRL_FUNCTION, written together as the profile */
+#define PROFILE_LEN	(CTRL_FUNCTION - CTRL_OSCILLATOR + 1)
+
+/*
+ * Century byte, kept in the RAM byte. Bit 0 is set while the year register
+ * is in 50..99, so a 99 -> 00 wrap the driver has not seen yet still shows
+ * as the bit set with a year below 50. Bit 5 is set once the date is past
+ * Feb 28 in 2100, 2200, 2300...: the chip takes every year 00 for a leap
+ * year, and the bit records that its Feb 29 has been put right.
+ */
+#define CENTURY_HALF	BIT(0)
+#define CENTURY_SHIFT	1
+#define CENTURY_MASK	GENMASK(4, 1)
+#define CENTURY_LEAP	BIT(5)
+#define CENTURY_MAX	9
+#define CENTURY_END	32503679999LL	/* 2999-12-31 23:59:59 */
+
+/*
+ * Where the time block lives and how the clock is held while it is set.
+ * The driver always works on the block in PCF85263 order, DT_100THS to
+ * DT_YEARS; a part without hundredths has its block start at buf[dt_skip]
+ * and buf[DT_100THS] reads as zero. stop_len is 2 when CTRL_RESETS follows
+ * the stop register and takes the prescaler clear in the same transfer.
+ */
+struct pcf85263_layout {
+	u8	dt_reg;
+	u8	dt_skip;
+	u8	stop_reg;
+	u8	stop_bit;
+	u8	stop_len;
+};
+
+/*
+ * Everything that differs between the supported parts, selected from the
+ * match data. The time paths are built once per layout with the layout as
+ * a compile-time constant, and reach the right build through rtc_ops.
+ */
+struct pcf85263_variant {
+	const struct pcf85263_layout	*layout;
+	const struct rtc_class_ops	*rtc_ops;
+	struct regmap_config		regmap;
+	unsigned int			features;
+	unsigned int			num_regs;	/* register file from 0x00 */
+	unsigned int			ram_size;
+	u8				rambyte_reg;
+	u8				offset_reg;
+	u8				hour_mode_reg;
+	u8				hour_mode_12h;
+	u8				cof_reg;
+};
+
+/*
+ * Header of the registers binary attribute, followed by regs_len bytes of
+ * the register file from 0x00 and ram_len bytes of RAM from 0x40.
+ */
+struct pcf85263_regdump_hdr {
+	char	magic[4];
+	u8	version;
+	u8	regs_len;
+	u8	ram_len;
+	u8	reserved;
+	__le64	timestamp;	/* CLOCK_REALTIME at capture, ns */
+} __packed;
 
 /*
- * Date/Time registers
- */
-#define DT_100THS	0x00
-#define DT_SECS		0x01
-#define DT_MINUTES	0x02
-#define DT_HOURS	0x03
-#define DT_DAYS		0x04
-#define DT_WEEKDAYS	0x05
-#define DT_MONTHS	0x06
-#define DT_YEARS	0x07
-
-/*
- * Alarm registers
- */
-#define DT_SECOND_ALM1	0x08
-#define DT_MINUTE_ALM1	0x09
-#define DT_HOUR_ALM1	0x0a
-#define DT_DAY_ALM1	0x0b
-#define DT_MONTH_ALM1	0x0c
-#define DT_MINUTE_ALM2	0x0d
-#define DT_HOUR_ALM2	0x0e
-#define DT_WEEKDAY_ALM2	0x0f
-#define DT_ALARM_EN	0x10
-
-/*
- * Time stamp registers
- */
-#define DT_TIMESTAMP1	0x11
-#define DT_TIMESTAMP2	0x17
-#define DT_TIMESTAMP3	0x1d
-#define DT_TS_MODE	0x23
-
-/*
- * control registers
- */
-#define CTRL_OFFSET	0x24
-#define CTRL_OSCILLATOR	0x25
-#define CTRL_BATTERY	0x26
-#define CTRL_PIN_IO	0x27
-#define CTRL_FUNCTION	0x28
-#define CTRL_INTA_EN	0x29
-#define CTRL_INTB_EN	0x2a
-#define CTRL_FLAGS	0x2b
-#define CTRL_RAMBYTE	0x2c
-#define CTRL_WDOG	0x2d
-#define CTRL_STOP_EN	0x2e
-#define CTRL_RESETS	0x2f
-#define CTRL_RAM	0x40
-
-#define ALRM_SEC_A1E	BIT(0)
-#define ALRM_MIN_A1E	BIT(1)
-#define ALRM_HR_A1E	BIT(2)
-#define ALRM_DAY_A1E	BIT(3)
-#define ALRM_MON_A1E	BIT(4)
-#define ALRM_MIN_A2E	BIT(5)
-#define ALRM_HR_A2E	BIT(6)
-#define ALRM_DAY_A2E	BIT(7)
-
-#define INT_WDIE	BIT(0)
-#define INT_BSIE	BIT(1)
-#define INT_TSRIE	BIT(2)
-#define INT_A2IE	BIT(3)
-#define INT_A1IE	BIT(4)
-#define INT_OIE		BIT(5)
-#define INT_PIE		BIT(6)
-#define INT_ILP		BIT(7)
-
-#define FLAGS_TSR1F	BIT(0)
-#define FLAGS_TSR2F	BIT(1)
-#define FLAGS_TSR3F	BIT(2)
-#define FLAGS_BSF	BIT(3)
-#define FLAGS_WDF	BIT(4)
-#define FLAGS_A1F	BIT(5)
-#define FLAGS_A2F	BIT(6)
-#define FLAGS_PIF	BIT(7)
-
-#define PIN_IO_INTAPM	GENMASK(1, 0)
-#define PIN_IO_INTA_CLK	0
-#define PIN_IO_INTA_BAT	1
-#define PIN_IO_INTA_OUT	2
-#define PIN_IO_INTA_HIZ	3
-
-#define STOP_EN_STOP	BIT(0)
-
-#define RESET_CPR	0xa4
-
-#define NVRAM_SIZE	0x01
-
-static struct i2c_driver pcf85263_driver;
+ * Times are seconds since 2000-01-01, the start of the chip's range.
+ * sync is the last set_time. The drift estimate is refreshed from the
+ * error accumulated over at least DRIFT_MIN_SPAN of successive sets.
+ */
+struct pcf85263_meta {
+	u8	magic;
+	u8	version;
+	u8	reserved[2];
+	__le32	sync;
+	__le32	span_start;
+	__le32	span_error;	/* 1/100 s, positive when the RTC ran fast */
+	__le32	drift_ppb;	/* positive when the RTC runs fast */
+	__le32	shutdown;	/* last clean shutdown, 0 if none */
+	u8	shutdown_hths;
+	u8	pad[META_SIZE - 25];
+} __packed;
+
+/*
+ * Boot timing, all on the chip's crystal: the previous shutdown from the
+ * metadata, the last power-up from timestamp 3, the probe from the
+ * register snapshot with the boot clock at that moment, and the ready
+ * mark from userspace.
+ */
+struct pcf85263_boot {
+	struct timespec64	shutdown;
+	struct timespec64	power_on;
+	struct timespec64	probe;
+	struct timespec64	ready;
+	u64			probe_boot_ns;
+	bool			shutdown_valid;
+	bool			power_on_valid;
+	bool			probe_valid;
+	bool			ready_valid;
+};
+
+/*
+ * Temperature compensation. The crystal error at temperature T, in ppb and
+ * positive when the RTC runs fast, is offset_ppb - coeff * (T - turnover)^2
+ * with T in degrees; CTRL_OFFSET is kept at the value that cancels it.
+ */
+struct pcf85263_tc {
+	const char		*zone;		/* name of the zone node */
+	struct thermal_zone_device *tz;
+	struct delayed_work	work;
+	unsigned int		interval_ms;
+	s32			turnover;	/* millicelsius */
+	u32			coeff;
+	s32			offset_ppb;
+	unsigned long		last_write;	/* jiffies */
+	bool			temp_valid;
+	int			temp;		/* millicelsius */
+	s32			error_ppb;
+	s8			offset;
+	unsigned int		writes;
+	unsigned int		limited;	/* changes held back */
+	unsigned int		errors;
+};
+
+/*
+ * The 12/24 hour mode, kept as a mask, PM bit, modulus and the value
+ * midnight/noon is written as. With 24-hour values of 0x3f, 0, 24 and 0
+ * the same arithmetic is a plain BCD conversion, so neither direction
+ * tests the mode.
+ */
+struct pcf85263_hours {
+	u8	mask;
+	u8	pm;
+	u8	mod;
+	u8	zero;
+};
 
 struct pcf85263 {
+	struct i2c_client	*client;
 	struct rtc_device	*rtc;
 	struct regmap		*regmap;
+	const struct pcf85263_variant *variant;
+	struct mutex		lock;
+	struct pcf85263_hours	hours;	/* read once at probe */
+	bool			century_en;
+	u8			century;
+	bool			stopwatch;
+	unsigned int		ram_size;
+	bool			drift;
+	bool			boot_timing;
+	struct pcf85263_meta	meta;
+	struct pcf85263_boot	boot;
+#ifdef PCF85263_SLEEPTIME
+	bool			inject_sleeptime;
+	bool			sleeptime_align;
+	bool			suspend_valid;
+	struct timespec64	suspend_ts;
+#endif
+	int			irq_b;
+	u8			intb_ie;	/* sources routed to INTB */
+	u8			intb_flags;	/* and their flags */
+	unsigned int		event_flags;
+	struct timespec64	event_ts;
+	bool			profile_en;
+	u8			profile_val[PROFILE_LEN];
+	u8			profile_mask[PROFILE_LEN];
+	bool			no_clkout;
+	bool			no_hths;
+	struct pcf85263_time_page *page;
+	struct delayed_work	page_work;
+	unsigned int		page_interval_ms;
+	struct miscdevice	page_misc;
+	struct pcf85263_tc	tc;
+#if IS_ENABLED(CONFIG_IIO_TRIGGER)
+	struct iio_trigger	*trig;
+	unsigned int		trig_pi;
+	bool			trig_enabled;
+#endif
+#if IS_ENABLED(CONFIG_PPS)
+	struct pps_device	*pps;
+	spinlock_t		pps_lock;	/* pps_ts, pps_pending */
+	struct pps_event_time	pps_ts;
+	bool			pps_pending;
+	bool			pps_shared;	/* other sources on the line */
+#endif
+#ifdef CONFIG_COMMON_CLK
+	struct clk_hw		clkout_hw;
+	unsigned int		clkout_cof;
+	bool			inta_clk;
+#endif
 };
 
-static int pcf85263_rtc_read_time(struct device *dev, struct rtc_time *tm)
+/* OSC_CL and OSC_OSCD values; the fourth setting repeats the third */
+static const u32 pcf85263_loads[] = { 7000, 6000, 12500 };		/* fF */
+static const u32 pcf85263_drives[] = { 100000, 60000, 500000 };	/* ohm */
+
+static const struct pcf85263_layout pcf85263_layout = {
+	.dt_reg = DT_100THS,
+	.dt_skip = DT_100THS,
+	.stop_reg = CTRL_STOP_EN,
+	.stop_bit = STOP_EN_STOP,
+	.stop_len = 2,
+};
+
+static const struct pcf85263_layout pcf85063_layout = {
+	.dt_reg = PCF85063_DT_SECS,
+	.dt_skip = DT_SECS,
+	.stop_reg = PCF85063_CTRL1,
+	.stop_bit = PCF85063_CTRL1_STOP,
+	.stop_len = 1,
+};
+
+static __always_inline int
+__pcf85263_read_dt(struct pcf85263 *pcf85263, unsigned char *buf,
+		   const struct pcf85263_layout *layout)
 {
-	struct pcf85263 *pcf85263 = dev_get_drvdata(dev);
-	unsigned char buf[DT_YEARS + 1];
-	int ret, len = sizeof(buf);
+	buf[DT_100THS] = 0;
 
-	/* read the RTC date and time registers all at once */
-	ret = regmap_bulk_read(pcf85263->regmap, DT_100THS, buf, len);
-	if (ret) {
-		dev_err(dev, "%s: error %d\n", __func__, ret);
+	return regmap_bulk_read(pcf85263->regmap, layout->dt_reg,
+				buf + layout->dt_skip,
+				DT_YEARS + 1 - layout->dt_skip);
+}
+
+/*
+ * Setting the time is stop, write, start: stopping also clears the
+ * prescaler, so the clock counts from the new value on the start write.
+ * The stop register is cached, so keeping its other bits costs no read.
+ * The steps are separate so a group can stop and start all of its members
+ * together. Must be called with pcf85263->lock held.
+ */
+static __always_inline int
+__pcf85263_stop(struct pcf85263 *pcf85263,
+		const struct pcf85263_layout *layout)
+{
+	unsigned char stop[2];
+	unsigned int ctrl;
+	int ret;
+
+	ret = regmap_read(pcf85263->regmap, layout->stop_reg, &ctrl);
+	if (ret)
 		return ret;
-	}
 
-	tm->tm_year = bcd2bin(buf[DT_YEARS]);
+	stop[0] = ctrl | layout->stop_bit;
+	stop[1] = RESET_CPR;
+	return regmap_bulk_write(pcf85263->regmap, layout->stop_reg,
+				 stop, layout->stop_len);
+}
+
+static __always_inline int
+__pcf85263_write_dt(struct pcf85263 *pcf85263, const unsigned char *buf,
+		    const struct pcf85263_layout *layout)
+{
+	return regmap_bulk_write(pcf85263->regmap, layout->dt_reg,
+				 buf + layout->dt_skip,
+				 DT_YEARS + 1 - layout->dt_skip);
+}
+
+static __always_inline int
+__pcf85263_start(struct pcf85263 *pcf85263,
+		 const struct pcf85263_layout *layout)
+{
+	return regmap_update_bits(pcf85263->regmap, layout->stop_reg,
+				  layout->stop_bit, 0);
+}
+
+/* Write a whole date/time block. Must be called with pcf85263->lock held. */
+static __always_inline int
+__pcf85263_write_time(struct pcf85263 *pcf85263, const unsigned char *buf,
+		      const struct pcf85263_layout *layout)
+{
+	int ret;
+
+	ret = __pcf85263_stop(pcf85263, layout);
+	if (ret)
+		return ret;
+
+	ret = __pcf85263_write_dt(pcf85263, buf, layout);
+	if (ret)
+		return ret;
+
+	return __pcf85263_start(pcf85263, layout);
+}
+
+static int pcf85263_write_time(struct pcf85263 *pcf85263,
+			       const unsigned char *buf)
+{
+	return __pcf85263_write_time(pcf85263, buf,
+				     pcf85263->variant->layout);
+}
+
+static void pcf85263_set_hour_mode(struct pcf85263_hours *hours, bool h12)
+{
+	hours->mask = h12 ? 0x1f : 0x3f;
+	hours->pm = h12 ? HOURS_PM : 0;
+	hours->mod = h12 ? 12 : 24;
+	hours->zero = h12 ? 12 : 0;
+}
+
+static inline unsigned int
+pcf85263_reg_to_hour(const struct pcf85263_hours *hours, unsigned char reg)
+{
+	return bcd2bin(reg & hours->mask) % hours->mod +
+	       !!(reg & hours->pm) * 12;
+}
+
+static inline unsigned char
+pcf85263_hour_to_reg(const struct pcf85263_hours *hours, unsigned int hour)
+{
+	unsigned int h = hour % hours->mod;
+
+	return bin2bcd(h + !h * hours->zero) | (hour >= 12) * hours->pm;
+}
+
+/* A year 00 the chip wrongly counts as a leap year */
+static bool pcf85263_leap_skip(unsigned int year)
+{
+	return year % 100 == 0 && !is_leap_year(year);
+}
+
+static bool pcf85263_century_valid(unsigned int century)
+{
+	return !(century & ~(CENTURY_MASK | CENTURY_HALF | CENTURY_LEAP)) &&
+	       (century & CENTURY_MASK) >> CENTURY_SHIFT <= CENTURY_MAX;
+}
+
+/*
+ * Decode buf in the given hour mode and century byte. Returns true when
+ * the chip ran through a Feb 29 that does not exist and needs moving on a
+ * day; tm is already the right date.
+ */
+static bool __pcf85263_regs_to_tm(const struct pcf85263_hours *hours,
+				  u8 century_byte, unsigned char *buf,
+				  struct rtc_time *tm)
+{
+	unsigned int year = bcd2bin(buf[DT_YEARS]);
+	unsigned int century;
+	bool late;
+
+	/* without a century byte this is always 0 and the range 2000-2099 */
+	century = ((century_byte & CENTURY_MASK) >> CENTURY_SHIFT) +
+		  ((century_byte & CENTURY_HALF) && year < 50);
+	tm->tm_year = century * 100 + year;
 	/* adjust for 1900 base of rtc_time */
 	tm->tm_year += 100;
 
@@ -139,102 +444,3453 @@ static int pcf85263_rtc_read_time(struct device *dev, struct rtc_time *tm)
 	tm->tm_sec = bcd2bin(buf[DT_SECS]);
 	buf[DT_MINUTES] &= 0x7F;
 	tm->tm_min = bcd2bin(buf[DT_MINUTES]);
-	tm->tm_hour = bcd2bin(buf[DT_HOURS]);
+	tm->tm_hour = pcf85263_reg_to_hour(hours, buf[DT_HOURS]);
 	tm->tm_mday = bcd2bin(buf[DT_DAYS]);
 	tm->tm_mon = bcd2bin(buf[DT_MONTHS]) - 1;
 
-	return 0;
+	/* Feb 29 comes out as Mar 1, later dates need the day added */
+	late = !(century_byte & CENTURY_LEAP) &&
+	       pcf85263_leap_skip(tm->tm_year + 1900) &&
+	       (tm->tm_mon > 1 || (tm->tm_mon == 1 && tm->tm_mday == 29));
+	if (late)
+		rtc_time64_to_tm(rtc_tm_to_time64(tm) +
+				 (tm->tm_mon > 1) * 24 * 3600, tm);
+
+	return late;
 }
 
-static int pcf85263_rtc_set_time(struct device *dev, struct rtc_time *tm)
+static bool pcf85263_regs_to_tm(const struct pcf85263 *pcf85263,
+				unsigned char *buf, struct rtc_time *tm)
 {
-	struct pcf85263 *pcf85263 = dev_get_drvdata(dev);
-	unsigned char tmp[11];
-	unsigned char *buf = &tmp[2];
-	int ret;
-
-	tmp[0] = STOP_EN_STOP;
-	tmp[1] = RESET_CPR;
+	return __pcf85263_regs_to_tm(&pcf85263->hours, pcf85263->century,
+				     buf, tm);
+}
 
+static void pcf85263_tm_to_regs(const struct pcf85263 *pcf85263,
+				struct rtc_time *tm, unsigned char *buf)
+{
 	buf[DT_100THS] = 0;
 	buf[DT_SECS] = bin2bcd(tm->tm_sec);
 	buf[DT_MINUTES] = bin2bcd(tm->tm_min);
-	buf[DT_HOURS] = bin2bcd(tm->tm_hour);
+	buf[DT_HOURS] = pcf85263_hour_to_reg(&pcf85263->hours, tm->tm_hour);
 	buf[DT_DAYS] = bin2bcd(tm->tm_mday);
 	buf[DT_WEEKDAYS] = tm->tm_wday;
 	buf[DT_MONTHS] = bin2bcd(tm->tm_mon + 1);
 	buf[DT_YEARS] = bin2bcd(tm->tm_year % 100);
+}
 
-	ret = regmap_bulk_write(pcf85263->regmap, CTRL_STOP_EN,
-				tmp, 2);
+/*
+ * Read the calendar as a timespec64. With align, keep re-reading until the
+ * hundredths register ticks over, so the sample sits on a 10 ms edge rather
+ * than anywhere inside it.
+ */
+static int pcf85263_read_ts64(struct pcf85263 *pcf85263,
+			      struct timespec64 *ts, bool align)
+{
+	const struct pcf85263_variant *variant = pcf85263->variant;
+	unsigned int tries = 0;
+	unsigned char buf[DT_YEARS + 1];
+	struct rtc_time tm;
+	unsigned char hths;
+	int ret;
+
+	/* without hundredths there is no edge closer than a second */
+	if (align && (variant->features & PCF_FEAT_100THS) &&
+	    !pcf85263->no_hths)
+		tries = ALIGN_TRIES;
+
+	ret = __pcf85263_read_dt(pcf85263, buf, variant->layout);
 	if (ret)
 		return ret;
 
-	ret = regmap_bulk_write(pcf85263->regmap, DT_100THS,
-				buf, sizeof(tmp) - 2);
+	hths = buf[DT_100THS];
+	while (tries--) {
+		ret = __pcf85263_read_dt(pcf85263, buf, variant->layout);
+		if (ret)
+			return ret;
+		if (buf[DT_100THS] != hths)
+			break;
+	}
+
+	pcf85263_regs_to_tm(pcf85263, buf, &tm);
+	ts->tv_sec = rtc_tm_to_time64(&tm);
+	ts->tv_nsec = bcd2bin(buf[DT_100THS]) * 10 * NSEC_PER_MSEC;
+
+	return 0;
+}
+
+/*
+ * Flags, the rest of the control block and the time in one transfer: the
+ * register address wraps from CTRL_RESETS to DT_100THS, so the time comes
+ * from the same instant as the flags. Only for the PCF85263 layout, and it
+ * bypasses the regmap cache, which is fine for a read.
+ */
+static int pcf85263_read_status(struct pcf85263 *pcf85263,
+				unsigned char *buf)
+{
+	struct i2c_client *client = pcf85263->client;
+	unsigned char reg = CTRL_FLAGS;
+	struct i2c_msg msgs[] = {
+		{
+			.addr = client->addr,
+			.len = 1,
+			.buf = &reg,
+		}, {
+			.addr = client->addr,
+			.flags = I2C_M_RD,
+			.len = STATUS_SIZE,
+			.buf = buf,
+		},
+	};
+	int ret;
+
+	ret = i2c_transfer(client->adapter, msgs, ARRAY_SIZE(msgs));
+	if (ret < 0)
+		return ret;
+
+	return ret == ARRAY_SIZE(msgs) ? 0 : -EIO;
+}
+
+static void pcf85263_status_to_ts(struct pcf85263 *pcf85263,
+				  unsigned char *buf, struct timespec64 *ts)
+{
+	struct rtc_time tm;
+
+	pcf85263_regs_to_tm(pcf85263, buf + STATUS_TIME, &tm);
+	ts->tv_sec = rtc_tm_to_time64(&tm);
+	ts->tv_nsec = bcd2bin(buf[STATUS_TIME + DT_100THS]) * 10 *
+		      NSEC_PER_MSEC;
+}
+
+static time64_t pcf85263_meta_time(__le32 t)
+{
+	return RTC_TIMESTAMP_BEGIN_2000 + le32_to_cpu(t);
+}
+
+/* Predict how far the RTC has drifted since the last sync and undo it */
+static time64_t pcf85263_drift_correct(struct pcf85263 *pcf85263,
+				       time64_t t)
+{
+	s32 ppb = le32_to_cpu(pcf85263->meta.drift_ppb);
+	time64_t sync = pcf85263_meta_time(pcf85263->meta.sync);
+
+	if (!pcf85263->meta.sync || t <= sync || !ppb)
+		return t;
+
+	return t - div_s64((t - sync) * ppb, NSEC_PER_SEC);
+}
+
+static int pcf85263_meta_store(struct pcf85263 *pcf85263)
+{
+	return regmap_raw_write(pcf85263->regmap, CTRL_RAM + META_OFFSET,
+				&pcf85263->meta, sizeof(pcf85263->meta));
+}
+
+/*
+ * Called from set_time before the new time is written, while the chip
+ * still holds its own idea of the time. Small errors count towards the
+ * drift measurement; anything larger than DRIFT_MAX_PPB can explain is a
+ * deliberate time change and restarts it. Must be called with
+ * pcf85263->lock held.
+ */
+static void pcf85263_drift_update(struct pcf85263 *pcf85263, time64_t t)
+{
+	struct pcf85263_meta *meta = &pcf85263->meta;
+	u32 now = t - RTC_TIMESTAMP_BEGIN_2000;
+	u32 sync = le32_to_cpu(meta->sync);
+	u32 start = le32_to_cpu(meta->span_start);
+	s32 error = le32_to_cpu(meta->span_error);
+	s32 ppb = le32_to_cpu(meta->drift_ppb);
+	struct timespec64 raw;
+	s64 err;
+
+	if (pcf85263_read_ts64(pcf85263, &raw, false) || !sync || now <= sync) {
+		start = now;
+		error = 0;
+		goto out;
+	}
+
+	err = (raw.tv_sec - t) * 100 + raw.tv_nsec / (10 * NSEC_PER_MSEC);
+	if (abs(err) * 10 * NSEC_PER_MSEC >
+	    (s64)(now - sync) * DRIFT_MAX_PPB + 20 * NSEC_PER_MSEC) {
+		start = now;
+		error = 0;
+		goto out;
+	}
+
+	error += err;
+	if (now - start >= DRIFT_MIN_SPAN) {
+		s32 measured = div_s64((s64)error * 10 * NSEC_PER_MSEC,
+				       now - start);
+
+		ppb = ppb ? (3 * ppb + measured) / 4 : measured;
+		start = now;
+		error = 0;
+	}
+
+out:
+	meta->sync = cpu_to_le32(now);
+	meta->span_start = cpu_to_le32(start);
+	meta->span_error = cpu_to_le32(error);
+	meta->drift_ppb = cpu_to_le32(ppb);
+}
+
+/* Must be called with pcf85263->lock held */
+static int pcf85263_century_store(struct pcf85263 *pcf85263,
+				  const struct rtc_time *tm)
+{
+	unsigned int year = tm->tm_year - 100;
+	u8 century = (year / 100) << CENTURY_SHIFT |
+		     (year % 100 >= 50 ? CENTURY_HALF : 0);
+	int ret;
+
+	if (pcf85263_leap_skip(tm->tm_year + 1900) && tm->tm_mon > 1)
+		century |= CENTURY_LEAP;
+
+	if (century == pcf85263->century)
+		return 0;
+
+	ret = regmap_write(pcf85263->regmap, pcf85263->variant->rambyte_reg,
+			   century);
+	if (!ret)
+		pcf85263->century = century;
+
+	return ret;
+}
+
+/*
+ * Move the chip on a day past the Feb 29 it ran through: buf is what was
+ * just read, tm the date regs_to_tm made of it, and the time of day is
+ * kept. Must be called with pcf85263->lock held since the read.
+ */
+static int pcf85263_leap_fix(struct pcf85263 *pcf85263, unsigned char *buf,
+			     const struct rtc_time *tm,
+			     const struct pcf85263_layout *layout)
+{
+	int ret;
+
+	buf[DT_DAYS] = bin2bcd(tm->tm_mday);
+	buf[DT_WEEKDAYS] = tm->tm_wday;
+	buf[DT_MONTHS] = bin2bcd(tm->tm_mon + 1);
+	buf[DT_YEARS] = bin2bcd(tm->tm_year % 100);
+	ret = __pcf85263_write_time(pcf85263, buf, layout);
 	if (ret)
 		return ret;
 
-	return regmap_write(pcf85263->regmap, CTRL_STOP_EN, 0);
+	return pcf85263_century_store(pcf85263, tm);
 }
 
-static const struct rtc_class_ops rtc_ops = {
-	.read_time	= pcf85263_rtc_read_time,
-	.set_time	= pcf85263_rtc_set_time,
-};
+/*
+ * Time page: the last hardware sample of the calendar, with hundredths,
+ * and the CLOCK_MONOTONIC instant it was taken at, for userspace to map
+ * and extrapolate from without a syscall (see pcf85263-page.h). Every
+ * read_time publishes its sample; a NULL ts marks the page invalid.
+ * Must be called with pcf85263->lock held, taken before the sample was
+ * read, so a sample never lands on top of a later set.
+ */
+static void pcf85263_page_publish(struct pcf85263 *pcf85263,
+				  const struct timespec64 *ts, u64 mono)
+{
+	struct pcf85263_time_page *page = pcf85263->page;
 
-static const struct regmap_config regmap_config = {
-	.reg_bits = 8,
-	.val_bits = 8,
-	.max_register = 0x2f,
-};
+	WRITE_ONCE(page->seq, page->seq + 1);
+	smp_wmb();
+	if (ts) {
+		WRITE_ONCE(page->rtc_sec, ts->tv_sec);
+		WRITE_ONCE(page->rtc_nsec, ts->tv_nsec);
+		WRITE_ONCE(page->mono_ns, mono);
+	}
+	WRITE_ONCE(page->flags, ts ? PCF85263_PAGE_VALID : 0);
+	smp_wmb();
+	WRITE_ONCE(page->seq, page->seq + 1);
+}
 
-static int pcf85263_probe(struct i2c_client *client,
-			  const struct i2c_device_id *id)
+static void pcf85263_page_sample(struct pcf85263 *pcf85263,
+				 struct rtc_time *tm, unsigned char hths,
+				 u64 mono)
 {
-	struct pcf85263 *pcf85263;
+	struct timespec64 ts;
+
+	/* the counter was somewhere in the tick, take its middle */
+	ts.tv_sec = rtc_tm_to_time64(tm);
+	if ((pcf85263->variant->features & PCF_FEAT_100THS) &&
+	    !pcf85263->no_hths)
+		ts.tv_nsec = bcd2bin(hths) * 10 * NSEC_PER_MSEC +
+			     5 * NSEC_PER_MSEC;
+	else
+		ts.tv_nsec = NSEC_PER_SEC / 2;
+
+	pcf85263_page_publish(pcf85263, &ts, mono);
+}
+
+static __always_inline int
+__pcf85263_rtc_read_time(struct device *dev, struct rtc_time *tm,
+			 const struct pcf85263_layout *layout)
+{
+	struct pcf85263 *pcf85263 = dev_get_drvdata(dev);
+	bool page = pcf85263->page;
+	unsigned char buf[DT_YEARS + 1];
+	u64 mono = 0;
+	bool late;
 	int ret;
 
-	if (!i2c_check_functionality(client->adapter, I2C_FUNC_I2C))
-		return -ENODEV;
+	/*
+	 * A set, by this device or its group, is never seen half done, and
+	 * the sample is published before any later set can publish its own.
+	 */
+	mutex_lock(&pcf85263->lock);
 
-	pcf85263 = devm_kzalloc(&client->dev, sizeof(struct pcf85263),
-				GFP_KERNEL);
-	if (!pcf85263)
-		return -ENOMEM;
+	/* the calendar is not running while in stopwatch mode */
+	if (pcf85263->stopwatch) {
+		ret = -EINVAL;
+		goto out;
+	}
 
-	pcf85263->regmap = devm_regmap_init_i2c(client, &regmap_config);
-	if (IS_ERR(pcf85263->regmap)) {
-		dev_err(&client->dev, "regmap allocation failed\n");
-		return PTR_ERR(pcf85263->regmap);
+	/* read the RTC date and time registers all at once */
+	if (page)
+		mono = ktime_get_ns();
+	ret = __pcf85263_read_dt(pcf85263, buf, layout);
+	if (ret) {
+		dev_err(dev, "%s: error %d\n", __func__, ret);
+		goto out;
 	}
+	/* the chip latched the time somewhere inside the transfer */
+	if (page)
+		mono += (ktime_get_ns() - mono) / 2;
 
-	i2c_set_clientdata(client, pcf85263);
+	/* the oscillator stopped at some point, the time is garbage */
+	if (buf[DT_SECS] & SECS_OS) {
+		if (page)
+			pcf85263_page_publish(pcf85263, NULL, 0);
+		dev_warn(dev, "oscillator stop detected, time is invalid\n");
+		ret = -EINVAL;
+		goto out;
+	}
 
-	pcf85263->rtc = devm_rtc_device_register(&client->dev,
-			pcf85263_driver.driver.name,
-			&rtc_ops,
-			THIS_MODULE);
+	late = pcf85263_regs_to_tm(pcf85263, buf, tm);
 
-	return PTR_ERR_OR_ZERO(pcf85263->rtc);
+	/* the byte only changes at 50, on a wrap and past a false Feb 29 */
+	if (late)
+		pcf85263_leap_fix(pcf85263, buf, tm, layout);
+	else if (pcf85263->century_en)
+		pcf85263_century_store(pcf85263, tm);
+
+	if (pcf85263->drift)
+		rtc_time64_to_tm(pcf85263_drift_correct(pcf85263,
+							rtc_tm_to_time64(tm)),
+				 tm);
+
+	if (page)
+		pcf85263_page_sample(pcf85263, tm, buf[DT_100THS], mono);
+out:
+	mutex_unlock(&pcf85263->lock);
+
+	return ret;
 }
 
-static const struct i2c_device_id dev_ids[] = {
-	{ "pcf85263", 0 },
-	{ }
-};
+static __always_inline int
+__pcf85263_rtc_set_time(struct device *dev, struct rtc_time *tm,
+			const struct pcf85263_layout *layout)
+{
+	struct pcf85263 *pcf85263 = dev_get_drvdata(dev);
+	unsigned char buf[DT_YEARS + 1];
+	int ret;
 
-MODULE_DEVICE_TABLE(i2c, dev_ids);
+	pcf85263_tm_to_regs(pcf85263, tm, buf);
 
-static struct i2c_driver pcf85263_driver = {
-	.driver	= {
-		.name	= "pcf85263",
-	},
-	.probe		= pcf85263_probe,
-	.id_table 	= dev_ids,
-};
+	mutex_lock(&pcf85263->lock);
+	if (pcf85263->stopwatch) {
+		ret = -EINVAL;
+		goto out;
+	}
+
+	if (pcf85263->drift)
+		pcf85263_drift_update(pcf85263, rtc_tm_to_time64(tm));
+
+	ret = __pcf85263_write_time(pcf85263, buf, layout);
+
+	/* the clock restarted from .00 as the write completed */
+	if (!ret && pcf85263->page) {
+		struct timespec64 ts = { .tv_sec = rtc_tm_to_time64(tm) };
+
+		pcf85263_page_publish(pcf85263, &ts, ktime_get_ns());
+	}
+
+	if (!ret && pcf85263->century_en)
+		ret = pcf85263_century_store(pcf85263, tm);
+
+	/*
+	 * The RAM is not contiguous with the time registers, so the metadata
+	 * goes out after the clock has been restarted rather than stretching
+	 * the stopped window.
+	 */
+	if (!ret && pcf85263->drift)
+		ret = pcf85263_meta_store(pcf85263);
+out:
+	mutex_unlock(&pcf85263->lock);
+
+	return ret;
+}
+
+static int pcf85263_rtc_read_time(struct device *dev, struct rtc_time *tm)
+{
+	return __pcf85263_rtc_read_time(dev, tm, &pcf85263_layout);
+}
+
+static int pcf85263_rtc_set_time(struct device *dev, struct rtc_time *tm)
+{
+	return __pcf85263_rtc_set_time(dev, tm, &pcf85263_layout);
+}
 
-module_i2c_driver(pcf85263_driver);
+static int pcf85063_rtc_read_time(struct device *dev, struct rtc_time *tm)
+{
+	return __pcf85263_rtc_read_time(dev, tm, &pcf85063_layout);
+}
+
+static int pcf85063_rtc_set_time(struct device *dev, struct rtc_time *tm)
+{
+	return __pcf85263_rtc_set_time(dev, tm, &pcf85063_layout);
+}
+
+static const struct rtc_class_ops pcf85263_rtc_ops = {
+	.read_time	= pcf85263_rtc_read_time,
+	.set_time	= pcf85263_rtc_set_time,
+};
+
+static const struct rtc_class_ops pcf85063_rtc_ops = {
+	.read_time	= pcf85063_rtc_read_time,
+	.set_time	= pcf85063_rtc_set_time,
+};
+
+/*
+ * Stopwatch mode: the date/time block counts elapsed hundredths of a second
+ * up to 999999:59:59.99, battery backed. The mode bit lives in the chip, so
+ * it survives a reboot and is only changed on request.
+ */
+static u64 pcf85263_sw_from_regs(const unsigned char *buf)
+{
+	u64 secs;
+	u32 hours;
+
+	hours = bcd2bin(buf[SW_HR_00_XX_XX]) * 10000 +
+		bcd2bin(buf[SW_HR_XX_00_XX]) * 100 +
+		bcd2bin(buf[SW_HR_XX_XX_00]);
+	secs = (u64)hours * 3600 +
+	       bcd2bin(buf[DT_MINUTES] & 0x7F) * 60 +
+	       bcd2bin(buf[DT_SECS] & 0x7F);
+
+	return secs * 100 + bcd2bin(buf[DT_100THS]);
+}
+
+static void pcf85263_sw_to_regs(u64 hths, unsigned char *buf)
+{
+	u32 hours;
+
+	buf[DT_100THS] = bin2bcd(do_div(hths, 100));
+	buf[DT_SECS] = bin2bcd(do_div(hths, 60));
+	buf[DT_MINUTES] = bin2bcd(do_div(hths, 60));
+	hours = hths;
+	buf[SW_HR_XX_XX_00] = bin2bcd(hours % 100);
+	buf[SW_HR_XX_00_XX] = bin2bcd(hours / 100 % 100);
+	buf[SW_HR_00_XX_XX] = bin2bcd(hours / 10000);
+	buf[DT_MONTHS] = 0;
+	buf[DT_YEARS] = 0;
+}
+
+/* Must be called with pcf85263->lock held */
+static int pcf85263_set_mode(struct pcf85263 *pcf85263, bool stopwatch)
+{
+	/* the counter restarts from zero, the calendar from 2000-01-01 */
+	unsigned char buf[DT_YEARS + 1] = {
+		[DT_HOURS] = stopwatch ? 0 :
+			     pcf85263_hour_to_reg(&pcf85263->hours, 0),
+		[DT_DAYS] = stopwatch ? 0 : 0x01,
+		[DT_WEEKDAYS] = stopwatch ? 0 : 6,
+		[DT_MONTHS] = stopwatch ? 0 : 0x01,
+	};
+	unsigned char stop[2] = { STOP_EN_STOP, RESET_CPR };
+	struct rtc_time epoch = { .tm_mday = 1, .tm_year = 100 };
+	int ret;
+
+	if (pcf85263->stopwatch == stopwatch)
+		return 0;
+
+	ret = regmap_bulk_write(pcf85263->regmap, CTRL_STOP_EN,
+				stop, sizeof(stop));
+	if (ret)
+		return ret;
+
+	ret = regmap_update_bits(pcf85263->regmap, CTRL_FUNCTION, FUNC_RTCM,
+				 stopwatch ? FUNC_RTCM : 0);
+	if (ret)
+		return ret;
+	pcf85263->stopwatch = stopwatch;
+
+	ret = pcf85263_write_time(pcf85263, buf);
+	if (!ret && !stopwatch && pcf85263->century_en)
+		ret = pcf85263_century_store(pcf85263, &epoch);
+
+	/* the next read publishes the calendar again */
+	if (pcf85263->page)
+		pcf85263_page_publish(pcf85263, NULL, 0);
+
+	return ret;
+}
+
+static const char * const pcf85263_modes[] = { "rtc", "stopwatch" };
+
+static ssize_t mode_show(struct device *dev, struct device_attribute *attr,
+			 char *buf)
+{
+	struct pcf85263 *pcf85263 = dev_get_drvdata(dev);
+
+	return sprintf(buf, "%s\n", pcf85263_modes[pcf85263->stopwatch]);
+}
+
+static ssize_t mode_store(struct device *dev, struct device_attribute *attr,
+			  const char *buf, size_t count)
+{
+	struct pcf85263 *pcf85263 = dev_get_drvdata(dev);
+	int mode, ret;
+
+	mode = sysfs_match_string(pcf85263_modes, buf);
+	if (mode < 0)
+		return mode;
+
+	mutex_lock(&pcf85263->lock);
+	ret = pcf85263_set_mode(pcf85263, mode);
+	mutex_unlock(&pcf85263->lock);
+
+	return ret ? ret : count;
+}
+
+static DEVICE_ATTR_RW(mode);
+
+static ssize_t stopwatch_show(struct device *dev,
+			      struct device_attribute *attr, char *buf)
+{
+	struct pcf85263 *pcf85263 = dev_get_drvdata(dev);
+	unsigned char regs[SW_HR_00_XX_XX + 1];
+	int ret;
+
+	/*
+	 * One bulk read, so the counter cannot carry between bytes, and
+	 * under the lock, so no preset or mode change lands in the middle.
+	 */
+	mutex_lock(&pcf85263->lock);
+	if (pcf85263->stopwatch)
+		ret = regmap_bulk_read(pcf85263->regmap, DT_100THS, regs,
+				       sizeof(regs));
+	else
+		ret = -EINVAL;
+	mutex_unlock(&pcf85263->lock);
+	if (ret)
+		return ret;
+
+	return sprintf(buf, "%llu\n", pcf85263_sw_from_regs(regs));
+}
+
+static ssize_t stopwatch_store(struct device *dev,
+			       struct device_attribute *attr,
+			       const char *buf, size_t count)
+{
+	struct pcf85263 *pcf85263 = dev_get_drvdata(dev);
+	unsigned char regs[DT_YEARS + 1];
+	u64 hths;
+	int ret;
+
+	ret = kstrtou64(buf, 0, &hths);
+	if (ret)
+		return ret;
+
+	/* 999999:59:59.99 */
+	if (hths >= 1000000ULL * 3600 * 100)
+		return -ERANGE;
+
+	pcf85263_sw_to_regs(hths, regs);
+
+	mutex_lock(&pcf85263->lock);
+	if (pcf85263->stopwatch)
+		ret = pcf85263_write_time(pcf85263, regs);
+	else
+		ret = -EINVAL;
+	mutex_unlock(&pcf85263->lock);
+
+	return ret ? ret : count;
+}
+
+static DEVICE_ATTR_RW(stopwatch);
+
+static ssize_t drift_ppb_show(struct device *dev,
+			      struct device_attribute *attr, char *buf)
+{
+	struct pcf85263 *pcf85263 = dev_get_drvdata(dev);
+
+	return sprintf(buf, "%d\n",
+		       (s32)le32_to_cpu(pcf85263->meta.drift_ppb));
+}
+
+static ssize_t drift_ppb_store(struct device *dev,
+			       struct device_attribute *attr,
+			       const char *buf, size_t count)
+{
+	struct pcf85263 *pcf85263 = dev_get_drvdata(dev);
+	int ppb, ret;
+
+	ret = kstrtoint(buf, 0, &ppb);
+	if (ret)
+		return ret;
+
+	if (abs(ppb) > DRIFT_MAX_PPB)
+		return -ERANGE;
+
+	/* a known drift, e.g. from factory calibration */
+	mutex_lock(&pcf85263->lock);
+	pcf85263->meta.drift_ppb = cpu_to_le32(ppb);
+	ret = pcf85263_meta_store(pcf85263);
+	mutex_unlock(&pcf85263->lock);
+
+	return ret ? ret : count;
+}
+
+static DEVICE_ATTR_RW(drift_ppb);
+
+static ssize_t last_sync_show(struct device *dev,
+			      struct device_attribute *attr, char *buf)
+{
+	struct pcf85263 *pcf85263 = dev_get_drvdata(dev);
+
+	if (!pcf85263->meta.sync)
+		return -ENODATA;
+
+	return sprintf(buf, "%lld\n",
+		       (long long)pcf85263_meta_time(pcf85263->meta.sync));
+}
+
+static DEVICE_ATTR_RO(last_sync);
+
+static ssize_t uncorrected_time_show(struct device *dev,
+				     struct device_attribute *attr, char *buf)
+{
+	struct pcf85263 *pcf85263 = dev_get_drvdata(dev);
+	struct timespec64 ts;
+	int ret;
+
+	/* as read_time does, so no set or mode change lands in the read */
+	mutex_lock(&pcf85263->lock);
+	if (pcf85263->stopwatch)
+		ret = -EINVAL;
+	else
+		ret = pcf85263_read_ts64(pcf85263, &ts, false);
+	mutex_unlock(&pcf85263->lock);
+	if (ret)
+		return ret;
+
+	return sprintf(buf, "%lld.%02ld\n", (long long)ts.tv_sec,
+		       ts.tv_nsec / (10 * NSEC_PER_MSEC));
+}
+
+static DEVICE_ATTR_RO(uncorrected_time);
+
+static ssize_t last_event_show(struct device *dev,
+			       struct device_attribute *attr, char *buf)
+{
+	struct pcf85263 *pcf85263 = dev_get_drvdata(dev);
+	struct timespec64 ts;
+	unsigned int flags;
+
+	mutex_lock(&pcf85263->lock);
+	flags = pcf85263->event_flags;
+	ts = pcf85263->event_ts;
+	mutex_unlock(&pcf85263->lock);
+
+	if (!flags)
+		return -ENODATA;
+
+	return sprintf(buf, "%#04x %lld.%02ld\n", flags, (long long)ts.tv_sec,
+		       ts.tv_nsec / (10 * NSEC_PER_MSEC));
+}
+
+static DEVICE_ATTR_RO(last_event);
+
+/* The profile as the chip has it, from the register cache */
+static ssize_t power_profile_show(struct device *dev,
+				  struct device_attribute *attr, char *buf)
+{
+	struct pcf85263 *pcf85263 = dev_get_drvdata(dev);
+	u8 regs[PROFILE_LEN];
+	unsigned int cl, oscd;
+	u8 osc, pin_io, func;
+	int ret;
+
+	mutex_lock(&pcf85263->lock);
+	ret = regmap_bulk_read(pcf85263->regmap, CTRL_OSCILLATOR, regs,
+			       sizeof(regs));
+	mutex_unlock(&pcf85263->lock);
+	if (ret)
+		return ret;
+
+	osc = regs[0];
+	pin_io = regs[CTRL_PIN_IO - CTRL_OSCILLATOR];
+	func = regs[CTRL_FUNCTION - CTRL_OSCILLATOR];
+	cl = min_t(unsigned int, osc & OSC_CL, ARRAY_SIZE(pcf85263_loads) - 1);
+	oscd = min_t(unsigned int, (osc & OSC_OSCD) >> OSC_OSCD_SHIFT,
+		     ARRAY_SIZE(pcf85263_drives) - 1);
+
+	return sprintf(buf,
+		       "load_ff %u\ndrive_ohms %u\nlow_jitter %d\n"
+		       "clkout %d\nhundredths %d\n",
+		       pcf85263_loads[cl], pcf85263_drives[oscd],
+		       !!(osc & OSC_LOWJ),
+		       !(pin_io & PIN_IO_CLKPM) &&
+		       (func & FUNC_COF) != FUNC_COF_LOW,
+		       !!(func & FUNC_100TH));
+}
+
+static DEVICE_ATTR_RO(power_profile);
+
+static ssize_t temp_compensation_show(struct device *dev,
+				      struct device_attribute *attr, char *buf)
+{
+	struct pcf85263 *pcf85263 = dev_get_drvdata(dev);
+	struct pcf85263_tc *tc = &pcf85263->tc;
+	ssize_t len;
+
+	mutex_lock(&pcf85263->lock);
+	if (tc->temp_valid)
+		len = sprintf(buf, "temperature_mc %d\nerror_ppb %d\n",
+			      tc->temp, tc->error_ppb);
+	else
+		len = sprintf(buf, "temperature_mc -\nerror_ppb -\n");
+
+	len += sprintf(buf + len,
+		       "offset %d\noffset_ppb %d\nwrites %u\n"
+		       "rate_limited %u\nerrors %u\n",
+		       tc->offset, tc->offset * OFFSET_LSB_PPB, tc->writes,
+		       tc->limited, tc->errors);
+	mutex_unlock(&pcf85263->lock);
+
+	return len;
+}
+
+static DEVICE_ATTR_RO(temp_compensation);
+
+static ssize_t time_page_interval_ms_show(struct device *dev,
+					  struct device_attribute *attr,
+					  char *buf)
+{
+	struct pcf85263 *pcf85263 = dev_get_drvdata(dev);
+
+	return sprintf(buf, "%u\n", READ_ONCE(pcf85263->page_interval_ms));
+}
+
+/* 0 refreshes the page only when something reads the RTC */
+static ssize_t time_page_interval_ms_store(struct device *dev,
+					   struct device_attribute *attr,
+					   const char *buf, size_t count)
+{
+	struct pcf85263 *pcf85263 = dev_get_drvdata(dev);
+	unsigned int val;
+	int ret;
+
+	ret = kstrtouint(buf, 0, &val);
+	if (ret)
+		return ret;
+	if (val && val < PAGE_INTERVAL_MIN)
+		return -EINVAL;
+
+	WRITE_ONCE(pcf85263->page_interval_ms, val);
+	WRITE_ONCE(pcf85263->page->interval_ms, val);
+	if (val)
+		mod_delayed_work(system_wq, &pcf85263->page_work, 0);
+	else
+		cancel_delayed_work_sync(&pcf85263->page_work);
+
+	return count;
+}
+
+static DEVICE_ATTR_RW(time_page_interval_ms);
+
+static s64 pcf85263_boot_cs(const struct timespec64 *end,
+			    const struct timespec64 *start)
+{
+	struct timespec64 d = timespec64_sub(*end, *start);
+
+	return d.tv_sec * 100 + d.tv_nsec / (10 * NSEC_PER_MSEC);
+}
+
+static int pcf85263_boot_print(char *buf, const char *name, bool valid,
+			       s64 cs)
+{
+	s64 secs;
+	s32 rem;
+
+	if (!valid)
+		return sprintf(buf, "%s -\n", name);
+
+	secs = div_s64_rem(cs, 100, &rem);
+
+	return sprintf(buf, "%s %s%lld.%02d\n", name, cs < 0 ? "-" : "",
+		       abs(secs), abs(rem));
+}
+
+/*
+ * Without a power cut since the shutdown (a reboot), timestamp 3 is older
+ * than the shutdown: nothing was off and everything until probe was
+ * firmware. Must be called with pcf85263->lock held.
+ */
+static ssize_t pcf85263_boot_show(struct pcf85263 *pcf85263, char *buf)
+{
+	struct pcf85263_boot *boot = &pcf85263->boot;
+	bool cut = boot->power_on_valid && boot->shutdown_valid &&
+		   timespec64_compare(&boot->power_on, &boot->shutdown) >= 0;
+	const struct timespec64 *up = cut ? &boot->power_on : &boot->shutdown;
+	ssize_t len = 0;
+
+	len += pcf85263_boot_print(buf + len, "power_off",
+				   boot->shutdown_valid && boot->power_on_valid,
+				   cut ? pcf85263_boot_cs(&boot->power_on,
+							  &boot->shutdown) : 0);
+	len += pcf85263_boot_print(buf + len, "firmware_to_probe",
+				   boot->shutdown_valid && boot->probe_valid,
+				   pcf85263_boot_cs(&boot->probe, up));
+	len += pcf85263_boot_print(buf + len, "kernel_to_probe",
+				   boot->probe_valid,
+				   div_u64(boot->probe_boot_ns,
+					   10 * NSEC_PER_MSEC));
+	len += pcf85263_boot_print(buf + len, "probe_to_ready",
+				   boot->probe_valid && boot->ready_valid,
+				   pcf85263_boot_cs(&boot->ready,
+						    &boot->probe));
+
+	return len;
+}
+
+static ssize_t boot_timing_show(struct device *dev,
+				struct device_attribute *attr, char *buf)
+{
+	struct pcf85263 *pcf85263 = dev_get_drvdata(dev);
+	ssize_t len;
+
+	mutex_lock(&pcf85263->lock);
+	len = pcf85263_boot_show(pcf85263, buf);
+	mutex_unlock(&pcf85263->lock);
+
+	return len;
+}
+
+static DEVICE_ATTR_RO(boot_timing);
+
+/* Any write marks the boot complete; only the first one counts */
+static ssize_t boot_complete_store(struct device *dev,
+				   struct device_attribute *attr,
+				   const char *buf, size_t count)
+{
+	struct pcf85263 *pcf85263 = dev_get_drvdata(dev);
+	struct pcf85263_boot *boot = &pcf85263->boot;
+	int ret = 0;
+
+	mutex_lock(&pcf85263->lock);
+	if (!boot->ready_valid) {
+		ret = pcf85263_read_ts64(pcf85263, &boot->ready, false);
+		boot->ready_valid = !ret;
+		if (!ret)
+			trace_pcf85263_boot_mark(dev, "ready", &boot->ready);
+	}
+	if (!ret) {
+		char msg[192];
+
+		/* the same lines, on one line of the log */
+		pcf85263_boot_show(pcf85263, msg);
+		strreplace(msg, '\n', ' ');
+		dev_info(dev, "boot timing: %s\n", msg);
+	}
+	mutex_unlock(&pcf85263->lock);
+
+	return ret ? ret : count;
+}
+
+static DEVICE_ATTR_WO(boot_complete);
+
+static struct attribute *pcf85263_attrs[] = {
+	&dev_attr_mode.attr,
+	&dev_attr_stopwatch.attr,
+	&dev_attr_drift_ppb.attr,
+	&dev_attr_last_sync.attr,
+	&dev_attr_uncorrected_time.attr,
+	&dev_attr_last_event.attr,
+	&dev_attr_power_profile.attr,
+	&dev_attr_temp_compensation.attr,
+	&dev_attr_time_page_interval_ms.attr,
+	&dev_attr_boot_timing.attr,
+	&dev_attr_boot_complete.attr,
+	NULL,
+};
+
+/*
+ * A consistent copy of the chip state for telemetry: the register file and
+ * the RAM come from one combined I2C transaction, taken under the driver
+ * lock so it can never catch a set_time half way through.
+ */
+static ssize_t registers_read(struct file *filp, struct kobject *kobj,
+			      struct bin_attribute *attr, char *buf,
+			      loff_t off, size_t count)
+{
+	struct i2c_client *client = to_i2c_client(kobj_to_dev(kobj));
+	struct pcf85263 *pcf85263 = i2c_get_clientdata(client);
+	unsigned char dump[sizeof(struct pcf85263_regdump_hdr) +
+			   SNAPSHOT_SIZE + RAM_SIZE];
+	struct pcf85263_regdump_hdr *hdr = (void *)dump;
+	unsigned char *regs = dump + sizeof(*hdr);
+	unsigned char addr[2] = { DT_100THS, CTRL_RAM };
+	unsigned int regs_len = pcf85263->variant->num_regs;
+	unsigned int ram_len = pcf85263->variant->ram_size;
+	struct i2c_msg msgs[] = {
+		{
+			.addr = client->addr,
+			.len = 1,
+			.buf = &addr[0],
+		}, {
+			.addr = client->addr,
+			.flags = I2C_M_RD,
+			.len = regs_len,
+			.buf = regs,
+		}, {
+			.addr = client->addr,
+			.len = 1,
+			.buf = &addr[1],
+		}, {
+			.addr = client->addr,
+			.flags = I2C_M_RD,
+			.len = ram_len,
+			.buf = regs + regs_len,
+		},
+	};
+	int num = ram_len ? 4 : 2;
+	size_t len = sizeof(*hdr) + regs_len + ram_len;
+	int ret;
+
+	if (off >= len)
+		return 0;
+
+	memcpy(hdr->magic, REGDUMP_MAGIC, sizeof(hdr->magic));
+	hdr->version = REGDUMP_VERSION;
+	hdr->regs_len = regs_len;
+	hdr->ram_len = ram_len;
+	hdr->reserved = 0;
+
+	mutex_lock(&pcf85263->lock);
+	hdr->timestamp = cpu_to_le64(ktime_get_real_ns());
+	ret = i2c_transfer(client->adapter, msgs, num);
+	mutex_unlock(&pcf85263->lock);
+	if (ret < 0)
+		return ret;
+	if (ret != num)
+		return -EIO;
+
+	count = min_t(size_t, count, len - off);
+	memcpy(buf, dump + off, count);
+
+	return count;
+}
+
+static BIN_ATTR_RO(registers, sizeof(struct pcf85263_regdump_hdr) +
+		   SNAPSHOT_SIZE + RAM_SIZE);
+
+static struct bin_attribute *pcf85263_bin_attrs[] = {
+	&bin_attr_registers,
+	NULL,
+};
+
+static umode_t pcf85263_attr_is_visible(struct kobject *kobj,
+					struct attribute *attr, int n)
+{
+	struct pcf85263 *pcf85263 = dev_get_drvdata(kobj_to_dev(kobj));
+
+	if (attr == &dev_attr_drift_ppb.attr ||
+	    attr == &dev_attr_last_sync.attr ||
+	    attr == &dev_attr_uncorrected_time.attr)
+		return pcf85263->drift ? attr->mode : 0;
+
+	if (attr == &dev_attr_last_event.attr ||
+	    attr == &dev_attr_power_profile.attr)
+		return pcf85263->variant->features & PCF_FEAT_INTAB ?
+		       attr->mode : 0;
+
+	if (attr == &dev_attr_time_page_interval_ms.attr)
+		return pcf85263->page ? attr->mode : 0;
+
+	if (attr == &dev_attr_temp_compensation.attr)
+		return pcf85263->tc.zone ? attr->mode : 0;
+
+	if (attr == &dev_attr_boot_timing.attr ||
+	    attr == &dev_attr_boot_complete.attr)
+		return pcf85263->boot_timing ? attr->mode : 0;
+
+	if (attr == &dev_attr_mode.attr || attr == &dev_attr_stopwatch.attr)
+		return pcf85263->variant->features & PCF_FEAT_STOPWATCH ?
+		       attr->mode : 0;
+
+	return attr->mode;
+}
+
+static const struct attribute_group pcf85263_attr_group = {
+	.attrs = pcf85263_attrs,
+	.bin_attrs = pcf85263_bin_attrs,
+	.is_visible = pcf85263_attr_is_visible,
+};
+
+/*
+ * Drift correction and boot timing need room for their metadata, which
+ * only the PCF85363 RAM has. The area is taken off the top of the RAM
+ * nvmem.
+ */
+static int pcf85263_init_meta(struct device *dev, struct pcf85263 *pcf85263)
+{
+	struct pcf85263_meta *meta = &pcf85263->meta;
+	bool drift = of_property_read_bool(dev->of_node,
+					   "nxp,drift-correction");
+	bool boot = of_property_read_bool(dev->of_node, "nxp,boot-timing");
+	int ret;
+
+	BUILD_BUG_ON(sizeof(struct pcf85263_meta) != META_SIZE);
+
+	pcf85263->ram_size = pcf85263->variant->ram_size;
+	if (!drift && !boot)
+		return 0;
+
+	if (pcf85263->ram_size < RAM_SIZE) {
+		dev_warn(dev, "no RAM for driver metadata\n");
+		return 0;
+	}
+
+	ret = regmap_raw_read(pcf85263->regmap, CTRL_RAM + META_OFFSET,
+			      meta, sizeof(*meta));
+	if (ret)
+		return ret;
+
+	if (meta->magic != META_MAGIC || meta->version != META_VERSION) {
+		memset(meta, 0, sizeof(*meta));
+		meta->magic = META_MAGIC;
+		meta->version = META_VERSION;
+	}
+
+	pcf85263->ram_size = META_OFFSET;
+	pcf85263->drift = drift;
+	pcf85263->boot_timing = boot;
+
+	return 0;
+}
+
+static int pcf85263_init_mode(struct device *dev, struct pcf85263 *pcf85263)
+{
+	unsigned int func;
+	int ret;
+
+	if (!(pcf85263->variant->features & PCF_FEAT_STOPWATCH))
+		return 0;
+
+	ret = regmap_read(pcf85263->regmap, CTRL_FUNCTION, &func);
+	if (ret)
+		return ret;
+
+	pcf85263->stopwatch = func & FUNC_RTCM;
+	if (!of_property_read_bool(dev->of_node, "nxp,stopwatch-mode"))
+		return 0;
+
+	mutex_lock(&pcf85263->lock);
+	ret = pcf85263_set_mode(pcf85263, true);
+	mutex_unlock(&pcf85263->lock);
+
+	return ret;
+}
+
+/*
+ * Extend the two-digit year with a century count in the RAM byte. A byte
+ * that was never written by the driver may hold anything, and then counts
+ * as the 2000s until the first set.
+ */
+static int pcf85263_init_century(struct device *dev,
+				 struct pcf85263 *pcf85263)
+{
+	unsigned int val;
+	int ret;
+
+	if (!of_property_read_bool(dev->of_node, "nxp,century-byte"))
+		return 0;
+
+	ret = regmap_read(pcf85263->regmap, pcf85263->variant->rambyte_reg,
+			  &val);
+	if (ret)
+		return ret;
+
+	if (!pcf85263_century_valid(val))
+		val = 0;
+	pcf85263->century = val;
+	pcf85263->century_en = true;
+
+	return 0;
+}
+
+/*
+ * Put a chip left in 12-hour mode back into 24-hour mode. The running
+ * time is re-encoded and written back, which costs at most the current
+ * hundredth (or second, without hundredths).
+ */
+static int pcf85263_normalize_24h(struct device *dev,
+				  struct pcf85263 *pcf85263)
+{
+	const struct pcf85263_variant *variant = pcf85263->variant;
+	unsigned char buf[DT_YEARS + 1];
+	unsigned int hour;
+	int ret;
+
+	if (pcf85263->hours.mod == 24 ||
+	    !of_property_read_bool(dev->of_node, "nxp,24-hour-mode"))
+		return 0;
+
+	mutex_lock(&pcf85263->lock);
+	ret = __pcf85263_read_dt(pcf85263, buf, variant->layout);
+	if (ret)
+		goto out;
+
+	ret = regmap_update_bits(pcf85263->regmap, variant->hour_mode_reg,
+				 variant->hour_mode_12h, 0);
+	if (ret)
+		goto out;
+
+	hour = pcf85263_reg_to_hour(&pcf85263->hours, buf[DT_HOURS]);
+	pcf85263_set_hour_mode(&pcf85263->hours, false);
+
+	/* the stopwatch counter does not depend on the mode */
+	if (!pcf85263->stopwatch) {
+		buf[DT_HOURS] = pcf85263_hour_to_reg(&pcf85263->hours, hour);
+		ret = pcf85263_write_time(pcf85263, buf);
+	}
+out:
+	mutex_unlock(&pcf85263->lock);
+
+	return ret;
+}
+
+static int pcf85263_profile_index(const u32 *table, unsigned int n, u32 val)
+{
+	unsigned int i;
+
+	for (i = 0; i < n; i++)
+		if (table[i] == val)
+			return i;
+
+	return -EINVAL;
+}
+
+static void pcf85263_profile_set(struct pcf85263 *pcf85263, unsigned int reg,
+				 u8 mask, u8 val)
+{
+	pcf85263->profile_mask[reg - CTRL_OSCILLATOR] |= mask;
+	pcf85263->profile_val[reg - CTRL_OSCILLATOR] |= val & mask;
+	pcf85263->profile_en = true;
+}
+
+/*
+ * The oscillator and power profile. All four registers are cached, so the
+ * profile is laid over the cached values and written back in one transfer;
+ * the bits it does not own keep whatever the rest of the driver set.
+ * Must be called with pcf85263->lock held.
+ */
+static int pcf85263_apply_profile(struct pcf85263 *pcf85263)
+{
+	u8 buf[PROFILE_LEN];
+	int i, ret;
+
+	if (!pcf85263->profile_en)
+		return 0;
+
+	ret = regmap_bulk_read(pcf85263->regmap, CTRL_OSCILLATOR, buf,
+			       sizeof(buf));
+	if (ret)
+		return ret;
+
+	for (i = 0; i < PROFILE_LEN; i++)
+		buf[i] = (buf[i] & ~pcf85263->profile_mask[i]) |
+			 pcf85263->profile_val[i];
+
+	return regmap_bulk_write(pcf85263->regmap, CTRL_OSCILLATOR, buf,
+				 sizeof(buf));
+}
+
+/*
+ * Only the PCF85263 and PCF85363 have these controls. Unset properties
+ * leave the chip as it is.
+ */
+static int pcf85263_init_profile(struct device *dev, struct pcf85263 *pcf85263)
+{
+	struct device_node *np = dev->of_node;
+	int idx, ret;
+	u32 val;
+
+	if (!(pcf85263->variant->features & PCF_FEAT_INTAB))
+		return 0;
+
+	if (!of_property_read_u32(np, "quartz-load-femtofarads", &val)) {
+		idx = pcf85263_profile_index(pcf85263_loads,
+					     ARRAY_SIZE(pcf85263_loads), val);
+		if (idx < 0) {
+			dev_err(dev, "unsupported quartz-load-femtofarads %u\n",
+				val);
+			return idx;
+		}
+		pcf85263_profile_set(pcf85263, CTRL_OSCILLATOR, OSC_CL, idx);
+	}
+
+	if (!of_property_read_u32(np, "nxp,quartz-drive-strength-ohms",
+				  &val)) {
+		idx = pcf85263_profile_index(pcf85263_drives,
+					     ARRAY_SIZE(pcf85263_drives), val);
+		if (idx < 0) {
+			dev_err(dev,
+				"unsupported nxp,quartz-drive-strength-ohms %u\n",
+				val);
+			return idx;
+		}
+		pcf85263_profile_set(pcf85263, CTRL_OSCILLATOR, OSC_OSCD,
+				     idx << OSC_OSCD_SHIFT);
+	}
+
+	if (of_property_read_bool(np, "nxp,quartz-low-jitter"))
+		pcf85263_profile_set(pcf85263, CTRL_OSCILLATOR, OSC_LOWJ,
+				     OSC_LOWJ);
+
+	/* CLK pin off, and INTA too when it would only carry the clock */
+	if (of_property_read_bool(np, "nxp,no-clkout")) {
+		pcf85263_profile_set(pcf85263, CTRL_PIN_IO, PIN_IO_CLKPM,
+				     PIN_IO_CLKPM);
+		if (pcf85263->client->irq <= 0)
+			pcf85263_profile_set(pcf85263, CTRL_PIN_IO,
+					     PIN_IO_INTAPM, PIN_IO_INTA_HIZ);
+		pcf85263_profile_set(pcf85263, CTRL_FUNCTION, FUNC_COF,
+				     FUNC_COF_LOW);
+		pcf85263->no_clkout = true;
+	}
+
+	if (of_property_read_bool(np, "nxp,no-hundredths")) {
+		pcf85263_profile_set(pcf85263, CTRL_FUNCTION, FUNC_100TH, 0);
+		pcf85263->no_hths = true;
+	}
+
+	mutex_lock(&pcf85263->lock);
+	ret = pcf85263_apply_profile(pcf85263);
+	mutex_unlock(&pcf85263->lock);
+
+	return ret;
+}
+
+static void pcf85263_page_work(struct work_struct *work)
+{
+	struct pcf85263 *pcf85263 = container_of(to_delayed_work(work),
+						 struct pcf85263, page_work);
+	unsigned int interval = READ_ONCE(pcf85263->page_interval_ms);
+	struct rtc_time tm;
+
+	/* publishes as it reads, under the lock like any other read */
+	pcf85263->variant->rtc_ops->read_time(&pcf85263->client->dev, &tm);
+
+	if (interval)
+		schedule_delayed_work(&pcf85263->page_work,
+				      msecs_to_jiffies(interval));
+}
+
+static void pcf85263_page_free(void *data)
+{
+	free_page((unsigned long)data);
+}
+
+static void pcf85263_cancel_delayed(void *data)
+{
+	cancel_delayed_work_sync(data);
+}
+
+/*
+ * The page itself is set up at probe, so read_time can publish from the
+ * first read; the device node is registered at the end of probe.
+ * The page outlives the driver while a file still holds it open.
+ */
+static int pcf85263_init_page(struct device *dev, struct pcf85263 *pcf85263)
+{
+	struct pcf85263_time_page *page;
+	int ret;
+
+	if (!of_property_read_bool(dev->of_node, "nxp,time-page"))
+		return 0;
+
+	page = (struct pcf85263_time_page *)get_zeroed_page(GFP_KERNEL);
+	if (!page)
+		return -ENOMEM;
+
+	ret = devm_add_action_or_reset(dev, pcf85263_page_free, page);
+	if (ret)
+		return ret;
+
+	pcf85263->page_interval_ms = PAGE_INTERVAL_MS;
+	of_property_read_u32(dev->of_node, "nxp,time-page-interval-ms",
+			     &pcf85263->page_interval_ms);
+	if (pcf85263->page_interval_ms &&
+	    pcf85263->page_interval_ms < PAGE_INTERVAL_MIN)
+		pcf85263->page_interval_ms = PAGE_INTERVAL_MIN;
+
+	page->version = PCF85263_PAGE_VERSION;
+	page->interval_ms = pcf85263->page_interval_ms;
+	INIT_DELAYED_WORK(&pcf85263->page_work, pcf85263_page_work);
+
+	ret = devm_add_action_or_reset(dev, pcf85263_cancel_delayed,
+				       &pcf85263->page_work);
+	if (ret)
+		return ret;
+
+	pcf85263->page = page;
+
+	return 0;
+}
+
+static int pcf85263_page_open(struct inode *inode, struct file *file)
+{
+	struct pcf85263 *pcf85263 = container_of(file->private_data,
+						 struct pcf85263, page_misc);
+	struct page *page = virt_to_page(pcf85263->page);
+
+	/* misc_open() calls this under misc_mtx, before any deregister */
+	get_page(page);
+	file->private_data = page;
+
+	return 0;
+}
+
+static int pcf85263_page_release(struct inode *inode, struct file *file)
+{
+	put_page(file->private_data);
+
+	return 0;
+}
+
+static int pcf85263_page_mmap(struct file *file, struct vm_area_struct *vma)
+{
+	if (vma->vm_pgoff || vma->vm_end - vma->vm_start != PAGE_SIZE)
+		return -EINVAL;
+	if (vma->vm_flags & VM_WRITE)
+		return -EPERM;
+
+	vma->vm_flags &= ~VM_MAYWRITE;
+
+	return vm_insert_page(vma, vma->vm_start, file->private_data);
+}
+
+static const struct file_operations pcf85263_page_fops = {
+	.owner		= THIS_MODULE,
+	.open		= pcf85263_page_open,
+	.release	= pcf85263_page_release,
+	.mmap		= pcf85263_page_mmap,
+};
+
+static void pcf85263_page_unregister(void *data)
+{
+	misc_deregister(data);
+}
+
+static int pcf85263_register_page(struct device *dev,
+				  struct pcf85263 *pcf85263)
+{
+	struct miscdevice *misc = &pcf85263->page_misc;
+	int ret;
+
+	misc->minor = MISC_DYNAMIC_MINOR;
+	misc->name = devm_kasprintf(dev, GFP_KERNEL, "pcf85263-%s",
+				    dev_name(dev));
+	if (!misc->name)
+		return -ENOMEM;
+	misc->fops = &pcf85263_page_fops;
+	misc->parent = dev;
+	misc->mode = 0444;
+
+	ret = misc_register(misc);
+	if (ret)
+		return ret;
+
+	ret = devm_add_action_or_reset(dev, pcf85263_page_unregister, misc);
+	if (ret)
+		return ret;
+
+	if (pcf85263->page_interval_ms)
+		schedule_delayed_work(&pcf85263->page_work, 0);
+
+	return 0;
+}
+
+/*
+ * One compensation step: read the zone, evaluate the model and write
+ * CTRL_OFFSET when the rounded value moves, at most once per
+ * TC_MIN_WRITE_MS. The zone is looked up until it shows up, the sensor
+ * may well probe after the RTC.
+ */
+static void pcf85263_tc_work(struct work_struct *work)
+{
+	struct pcf85263 *pcf85263 = container_of(to_delayed_work(work),
+						 struct pcf85263, tc.work);
+	struct pcf85263_tc *tc = &pcf85263->tc;
+	struct thermal_zone_device *tz;
+	int temp, ret;
+	s64 dt, ppb;
+	s8 val;
+
+	if (!tc->tz) {
+		tz = thermal_zone_get_zone_by_name(tc->zone);
+		if (!IS_ERR(tz))
+			tc->tz = tz;
+	}
+	ret = tc->tz ? thermal_zone_get_temp(tc->tz, &temp) : -ENODEV;
+
+	mutex_lock(&pcf85263->lock);
+	if (ret) {
+		tc->errors++;
+		goto out;
+	}
+
+	/* far enough out for any sensor, and the square fits */
+	dt = clamp_t(s64, temp - tc->turnover, -TC_DT_MAX, TC_DT_MAX);
+	ppb = tc->offset_ppb - div_s64(tc->coeff * dt * dt, 1000000);
+	tc->temp = temp;
+	tc->error_ppb = clamp_t(s64, ppb, S32_MIN, S32_MAX);
+	tc->temp_valid = true;
+
+	/* a positive offset slows the clock down, rounded to the nearest step */
+	ppb += ppb < 0 ? -OFFSET_LSB_PPB / 2 : OFFSET_LSB_PPB / 2;
+	val = clamp_t(s64, div_s64(ppb, OFFSET_LSB_PPB), S8_MIN, S8_MAX);
+
+	if (val == tc->offset)
+		goto out;
+
+	if (tc->writes && time_before(jiffies, tc->last_write +
+				      msecs_to_jiffies(TC_MIN_WRITE_MS))) {
+		tc->limited++;
+		goto out;
+	}
+
+	ret = regmap_write(pcf85263->regmap, CTRL_OFFSET, (u8)val);
+	if (ret) {
+		tc->errors++;
+		goto out;
+	}
+
+	tc->offset = val;
+	tc->last_write = jiffies;
+	tc->writes++;
+out:
+	mutex_unlock(&pcf85263->lock);
+
+	schedule_delayed_work(&tc->work, msecs_to_jiffies(tc->interval_ms));
+}
+
+/*
+ * Only the PCF85263 and PCF85363 offset register has the 2.170 ppm step.
+ * OFFM goes into the profile, so it is written with it at probe and on
+ * resume: corrections then come every 8 minutes instead of every 4 hours,
+ * and a new offset takes effect before the temperature moves on.
+ */
+static int pcf85263_init_tc(struct device *dev, struct pcf85263 *pcf85263,
+			    const unsigned char *regs)
+{
+	struct device_node *np = dev->of_node;
+	struct pcf85263_tc *tc = &pcf85263->tc;
+	struct device_node *zone_np;
+	const char *zone;
+	int ret;
+
+	zone_np = of_parse_phandle(np, "nxp,temp-comp-zone", 0);
+	if (!zone_np)
+		return 0;
+
+	/* of-thermal registers each zone under the name of its node */
+	zone = devm_kstrdup(dev, zone_np->name, GFP_KERNEL);
+	of_node_put(zone_np);
+	if (!zone)
+		return -ENOMEM;
+
+	if (!(pcf85263->variant->features & PCF_FEAT_INTAB)) {
+		dev_warn(dev, "no temperature compensation on this part\n");
+		return 0;
+	}
+
+	tc->turnover = TC_TURNOVER;
+	of_property_read_s32(np, "nxp,temp-comp-turnover-millicelsius",
+			     &tc->turnover);
+	tc->coeff = TC_COEFF;
+	of_property_read_u32(np, "nxp,temp-comp-coefficient-ppb", &tc->coeff);
+	of_property_read_s32(np, "nxp,temp-comp-offset-ppb", &tc->offset_ppb);
+	tc->interval_ms = TC_INTERVAL_MS;
+	of_property_read_u32(np, "nxp,temp-comp-interval-ms", &tc->interval_ms);
+
+	if (tc->coeff > TC_COEFF_MAX ||
+	    abs(tc->offset_ppb) > S8_MAX * OFFSET_LSB_PPB) {
+		dev_err(dev, "temperature compensation model out of range\n");
+		return -EINVAL;
+	}
+	if (tc->interval_ms < TC_INTERVAL_MIN)
+		tc->interval_ms = TC_INTERVAL_MIN;
+
+	/* whatever calibration is in the chip stands until the first step */
+	tc->offset = regs[CTRL_OFFSET];
+	pcf85263_profile_set(pcf85263, CTRL_OSCILLATOR, OSC_OFFM, OSC_OFFM);
+	INIT_DELAYED_WORK(&tc->work, pcf85263_tc_work);
+
+	ret = devm_add_action_or_reset(dev, pcf85263_cancel_delayed,
+				       &tc->work);
+	if (ret)
+		return ret;
+
+	tc->zone = zone;
+
+	return 0;
+}
+
+/*
+ * Everything comes from the register snapshot probe already took: the time
+ * block, and timestamp 3, which records the last switch from the battery
+ * back to VDD. Timestamps have no hundredths.
+ */
+static int pcf85263_init_boot(struct device *dev, struct pcf85263 *pcf85263,
+			      const unsigned char *regs, u64 boot_ns)
+{
+	const struct pcf85263_variant *variant = pcf85263->variant;
+	struct pcf85263_boot *boot = &pcf85263->boot;
+	struct pcf85263_meta *meta = &pcf85263->meta;
+	const unsigned char *tsr = regs + DT_TIMESTAMP3;
+	unsigned char buf[DT_YEARS + 1];
+	struct pcf85263_hours hours;
+	struct rtc_time tm;
+
+	if (!pcf85263->boot_timing)
+		return 0;
+
+	/* the snapshot and timestamp are in the mode the chip was in then */
+	pcf85263_set_hour_mode(&hours, regs[variant->hour_mode_reg] &
+				       variant->hour_mode_12h);
+
+	if (meta->shutdown) {
+		boot->shutdown.tv_sec = pcf85263_meta_time(meta->shutdown);
+		boot->shutdown.tv_nsec = meta->shutdown_hths * 10 *
+					 NSEC_PER_MSEC;
+		boot->shutdown_valid = true;
+		trace_pcf85263_boot_mark(dev, "shutdown", &boot->shutdown);
+	}
+
+	if (!pcf85263->stopwatch && !(regs[DT_SECS] & SECS_OS)) {
+		memcpy(buf, regs, sizeof(buf));
+		__pcf85263_regs_to_tm(&hours, pcf85263->century, buf, &tm);
+		boot->probe.tv_sec = rtc_tm_to_time64(&tm);
+		boot->probe.tv_nsec = bcd2bin(buf[DT_100THS]) * 10 *
+				      NSEC_PER_MSEC;
+		boot->probe_boot_ns = boot_ns;
+		boot->probe_valid = true;
+		trace_pcf85263_boot_mark(dev, "probe", &boot->probe);
+	}
+
+	/* an empty timestamp reads as month 0 */
+	if ((variant->features & PCF_FEAT_TIMESTAMPS) &&
+	    !pcf85263->stopwatch && tsr[4]) {
+		buf[DT_100THS] = 0;
+		buf[DT_SECS] = tsr[0];
+		buf[DT_MINUTES] = tsr[1];
+		buf[DT_HOURS] = tsr[2];
+		buf[DT_DAYS] = tsr[3];
+		buf[DT_WEEKDAYS] = 0;
+		buf[DT_MONTHS] = tsr[4];
+		buf[DT_YEARS] = tsr[5];
+		__pcf85263_regs_to_tm(&hours, pcf85263->century, buf, &tm);
+		boot->power_on.tv_sec = rtc_tm_to_time64(&tm);
+		boot->power_on_valid = true;
+		trace_pcf85263_boot_mark(dev, "power_on", &boot->power_on);
+	}
+
+	return regmap_update_bits(pcf85263->regmap, DT_TS_MODE, TS_MODE_TSR3M,
+				  TS_MODE_TSR3_VDD);
+}
+
+/* Stamp the clean shutdown into the metadata, for the next boot */
+static void pcf85263_shutdown(struct i2c_client *client)
+{
+	struct pcf85263 *pcf85263 = i2c_get_clientdata(client);
+	struct timespec64 ts;
+
+	if (!pcf85263->boot_timing || pcf85263->stopwatch)
+		return;
+
+	mutex_lock(&pcf85263->lock);
+	if (!pcf85263_read_ts64(pcf85263, &ts, false)) {
+		pcf85263->meta.shutdown =
+			cpu_to_le32(ts.tv_sec - RTC_TIMESTAMP_BEGIN_2000);
+		pcf85263->meta.shutdown_hths = ts.tv_nsec /
+					       (10 * NSEC_PER_MSEC);
+		pcf85263_meta_store(pcf85263);
+	}
+	mutex_unlock(&pcf85263->lock);
+}
+
+/*
+ * The RAM byte and the PCF85363 RAM are plain byte arrays, so both nvmem
+ * providers go through the raw regmap accessors: any offset and length is a
+ * single auto-incrementing I2C transfer straight into the caller's buffer.
+ */
+static int pcf85263_rambyte_read(void *priv, unsigned int offset,
+				 void *val, size_t bytes)
+{
+	struct pcf85263 *pcf85263 = priv;
+
+	return regmap_raw_read(pcf85263->regmap,
+			       pcf85263->variant->rambyte_reg + offset,
+			       val, bytes);
+}
+
+static int pcf85263_rambyte_write(void *priv, unsigned int offset,
+				  void *val, size_t bytes)
+{
+	struct pcf85263 *pcf85263 = priv;
+
+	return regmap_raw_write(pcf85263->regmap,
+				pcf85263->variant->rambyte_reg + offset,
+				val, bytes);
+}
+
+static int pcf85263_ram_read(void *priv, unsigned int offset,
+			     void *val, size_t bytes)
+{
+	struct pcf85263 *pcf85263 = priv;
+
+	return regmap_raw_read(pcf85263->regmap, CTRL_RAM + offset,
+			       val, bytes);
+}
+
+static int pcf85263_ram_write(void *priv, unsigned int offset,
+			      void *val, size_t bytes)
+{
+	struct pcf85263 *pcf85263 = priv;
+
+	return regmap_raw_write(pcf85263->regmap, CTRL_RAM + offset,
+				val, bytes);
+}
+
+static int pcf85263_register_nvmem(struct device *dev,
+				   struct pcf85263 *pcf85263)
+{
+	struct nvmem_config nvmem_cfg[] = {
+		{
+			.name = "rambyte",
+			.word_size = 1,
+			.stride = 1,
+			.size = NVRAM_SIZE,
+			.reg_read = pcf85263_rambyte_read,
+			.reg_write = pcf85263_rambyte_write,
+		}, {
+			.name = "ram",
+			.word_size = 1,
+			.stride = 1,
+			.size = pcf85263->ram_size,
+			.reg_read = pcf85263_ram_read,
+			.reg_write = pcf85263_ram_write,
+		},
+	};
+	unsigned int num_nvram = pcf85263->ram_size ? 2 : 1;
+	struct nvmem_device *nvmem;
+	unsigned int i;
+
+	/* the RAM byte belongs to the driver when it holds the century */
+	for (i = pcf85263->century_en ? 1 : 0; i < num_nvram; i++) {
+		/* one chip per bus address, so the client name keeps it unique */
+		nvmem_cfg[i].name = devm_kasprintf(dev, GFP_KERNEL, "%s-%s",
+						   dev_name(dev),
+						   nvmem_cfg[i].name);
+		if (!nvmem_cfg[i].name)
+			return -ENOMEM;
+		nvmem_cfg[i].dev = dev;
+		nvmem_cfg[i].owner = THIS_MODULE;
+		nvmem_cfg[i].priv = pcf85263;
+
+		nvmem = devm_nvmem_register(dev, &nvmem_cfg[i]);
+		if (IS_ERR(nvmem)) {
+			dev_err(dev, "%s: registration failed\n",
+				nvmem_cfg[i].name);
+			return PTR_ERR(nvmem);
+		}
+	}
+
+	return 0;
+}
+
+#ifdef CONFIG_COMMON_CLK
+/*
+ * Handling of the CLK output, indexed by the COF field of cof_reg:
+ * CTRL_FUNCTION on the PCF85263, Control_2 on the PCF85063.
+ * The last COF value holds the output static low, which is how the clock
+ * is gated while unprepared; the selected rate is kept in clkout_cof.
+ */
+static const int clkout_rates[] = {
+	32768,
+	16384,
+	8192,
+	4096,
+	2048,
+	1024,
+	1,
+};
+
+#define clkout_hw_to_pcf85263(_hw) \
+	container_of(_hw, struct pcf85263, clkout_hw)
+
+static unsigned long pcf85263_clkout_recalc_rate(struct clk_hw *hw,
+						 unsigned long parent_rate)
+{
+	struct pcf85263 *pcf85263 = clkout_hw_to_pcf85263(hw);
+
+	return clkout_rates[pcf85263->clkout_cof];
+}
+
+static long pcf85263_clkout_round_rate(struct clk_hw *hw, unsigned long rate,
+				       unsigned long *prate)
+{
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(clkout_rates); i++)
+		if (clkout_rates[i] <= rate)
+			return clkout_rates[i];
+
+	return clkout_rates[ARRAY_SIZE(clkout_rates) - 1];
+}
+
+static int pcf85263_clkout_set_rate(struct clk_hw *hw, unsigned long rate,
+				    unsigned long parent_rate)
+{
+	struct pcf85263 *pcf85263 = clkout_hw_to_pcf85263(hw);
+	unsigned int cof;
+	int i, ret;
+
+	for (i = 0; i < ARRAY_SIZE(clkout_rates); i++)
+		if (clkout_rates[i] == rate)
+			break;
+	if (i == ARRAY_SIZE(clkout_rates))
+		return -EINVAL;
+
+	mutex_lock(&pcf85263->lock);
+	ret = regmap_read(pcf85263->regmap, pcf85263->variant->cof_reg, &cof);
+	if (ret)
+		goto out;
+
+	/* only touch the hardware if the output is currently running */
+	if ((cof & FUNC_COF) != FUNC_COF_LOW) {
+		ret = regmap_update_bits(pcf85263->regmap,
+					 pcf85263->variant->cof_reg,
+					 FUNC_COF, i);
+		if (ret)
+			goto out;
+	}
+
+	pcf85263->clkout_cof = i;
+out:
+	mutex_unlock(&pcf85263->lock);
+
+	return ret;
+}
+
+/*
+ * The clk ops share CTRL_PIN_IO and the COF register with the interrupt,
+ * mode and profile paths, so each read-modify-write is done under the lock.
+ */
+static int pcf85263_clkout_prepare(struct clk_hw *hw)
+{
+	struct pcf85263 *pcf85263 = clkout_hw_to_pcf85263(hw);
+	unsigned int mask = PIN_IO_CLKPM, val = 0, pin_io;
+	int ret = 0;
+
+	mutex_lock(&pcf85263->lock);
+	if (pcf85263->variant->features & PCF_FEAT_INTAB) {
+		ret = regmap_read(pcf85263->regmap, CTRL_PIN_IO, &pin_io);
+		if (ret)
+			goto out;
+
+		/*
+		 * INTA doubles as a clock output when nothing uses it for
+		 * interrupts, and stays as it is once something has made it
+		 * an interrupt output.
+		 */
+		if (pcf85263->inta_clk &&
+		    (pin_io & PIN_IO_INTAPM) != PIN_IO_INTA_OUT) {
+			mask |= PIN_IO_INTAPM;
+			val |= PIN_IO_INTA_CLK;
+		}
+
+		ret = regmap_update_bits(pcf85263->regmap, CTRL_PIN_IO,
+					 mask, val);
+		if (ret)
+			goto out;
+	}
+
+	ret = regmap_update_bits(pcf85263->regmap, pcf85263->variant->cof_reg,
+				 FUNC_COF, pcf85263->clkout_cof);
+out:
+	mutex_unlock(&pcf85263->lock);
+
+	return ret;
+}
+
+static void pcf85263_clkout_unprepare(struct clk_hw *hw)
+{
+	struct pcf85263 *pcf85263 = clkout_hw_to_pcf85263(hw);
+
+	mutex_lock(&pcf85263->lock);
+	regmap_update_bits(pcf85263->regmap, pcf85263->variant->cof_reg,
+			   FUNC_COF, FUNC_COF_LOW);
+	if (pcf85263->variant->features & PCF_FEAT_INTAB)
+		regmap_update_bits(pcf85263->regmap, CTRL_PIN_IO,
+				   PIN_IO_CLKPM, PIN_IO_CLKPM);
+	mutex_unlock(&pcf85263->lock);
+}
+
+static int pcf85263_clkout_is_prepared(struct clk_hw *hw)
+{
+	struct pcf85263 *pcf85263 = clkout_hw_to_pcf85263(hw);
+	unsigned int buf;
+	int ret;
+
+	ret = regmap_read(pcf85263->regmap, pcf85263->variant->cof_reg, &buf);
+	if (ret < 0)
+		return ret;
+
+	return (buf & FUNC_COF) != FUNC_COF_LOW;
+}
+
+static const struct clk_ops pcf85263_clkout_ops = {
+	.prepare = pcf85263_clkout_prepare,
+	.unprepare = pcf85263_clkout_unprepare,
+	.is_prepared = pcf85263_clkout_is_prepared,
+	.recalc_rate = pcf85263_clkout_recalc_rate,
+	.round_rate = pcf85263_clkout_round_rate,
+	.set_rate = pcf85263_clkout_set_rate,
+};
+
+static int pcf85263_clkout_register(struct i2c_client *client,
+				    struct pcf85263 *pcf85263)
+{
+	struct device_node *node = client->dev.of_node;
+	struct clk_init_data init;
+	unsigned int buf;
+	int ret;
+
+	ret = regmap_read(pcf85263->regmap, pcf85263->variant->cof_reg, &buf);
+	if (ret < 0)
+		return ret;
+
+	/* a gated output gives no hint of the rate, default to 32.768 kHz */
+	pcf85263->clkout_cof = buf & FUNC_COF;
+	if (pcf85263->clkout_cof == FUNC_COF_LOW)
+		pcf85263->clkout_cof = 0;
+	pcf85263->inta_clk = client->irq <= 0 &&
+			     (pcf85263->variant->features & PCF_FEAT_INTAB);
+
+	init.name = devm_kasprintf(&client->dev, GFP_KERNEL, "%s-clkout",
+				   dev_name(&client->dev));
+	if (!init.name)
+		return -ENOMEM;
+	init.ops = &pcf85263_clkout_ops;
+	init.flags = 0;
+	init.parent_names = NULL;
+	init.num_parents = 0;
+	pcf85263->clkout_hw.init = &init;
+
+	/* optional override of the clockname */
+	if (node)
+		of_property_read_string(node, "clock-output-names",
+					&init.name);
+
+	ret = devm_clk_hw_register(&client->dev, &pcf85263->clkout_hw);
+	if (ret)
+		return ret;
+
+	if (!node)
+		return 0;
+
+	return devm_of_clk_add_hw_provider(&client->dev, of_clk_hw_simple_get,
+					   &pcf85263->clkout_hw);
+}
+#endif
+
+/*
+ * Interrupt sources, each routed to INTA or INTB, with the variant feature
+ * that provides them. The offset correction pulse has no flag.
+ */
+static const struct {
+	const char	*name;
+	u8		ie;
+	u8		flags;
+	u32		feature;
+} pcf85263_int_sources[] = {
+	{ "alarm1", INT_A1IE, FLAGS_A1F, PCF_FEAT_ALARM1 },
+	{ "alarm2", INT_A2IE, FLAGS_A2F, PCF_FEAT_ALARM2 },
+	{ "periodic", INT_PIE, FLAGS_PIF, PCF_FEAT_INTAB },
+	{ "timestamp", INT_TSRIE, FLAGS_TSR1F | FLAGS_TSR2F | FLAGS_TSR3F,
+	  PCF_FEAT_TIMESTAMPS },
+	{ "battery", INT_BSIE, FLAGS_BSF, PCF_FEAT_INTAB },
+	{ "watchdog", INT_WDIE, FLAGS_WDF, PCF_FEAT_INTAB },
+	{ "offset", INT_OIE, 0, PCF_FEAT_INTAB },
+};
+
+/* The enable register of the line a source is routed to */
+static unsigned int pcf85263_int_reg(struct pcf85263 *pcf85263, u8 ie)
+{
+	return pcf85263->intb_ie & ie ? CTRL_INTB_EN : CTRL_INTA_EN;
+}
+
+/*
+ * Sources listed in nxp,intb-sources go to INTB, everything else stays on
+ * INTA. Without an "intb" interrupt there is nobody to service INTB, so
+ * the list is ignored.
+ */
+static int pcf85263_init_routing(struct device *dev,
+				 struct pcf85263 *pcf85263)
+{
+	struct device_node *node = dev->of_node;
+	const char *name;
+	int i, j, n;
+
+	n = of_property_count_strings(node, "nxp,intb-sources");
+	if (n <= 0)
+		return 0;
+
+	pcf85263->irq_b = of_irq_get_byname(node, "intb");
+	if (pcf85263->irq_b <= 0) {
+		dev_warn(dev, "no intb interrupt, all sources stay on INTA\n");
+		pcf85263->irq_b = 0;
+		return 0;
+	}
+
+	for (i = 0; i < n; i++) {
+		if (of_property_read_string_index(node, "nxp,intb-sources",
+						  i, &name))
+			return -EINVAL;
+
+		for (j = 0; j < ARRAY_SIZE(pcf85263_int_sources); j++)
+			if (!strcmp(name, pcf85263_int_sources[j].name))
+				break;
+		if (j == ARRAY_SIZE(pcf85263_int_sources) ||
+		    !(pcf85263->variant->features &
+		      pcf85263_int_sources[j].feature)) {
+			dev_err(dev, "unknown interrupt source %s\n", name);
+			return -EINVAL;
+		}
+
+		pcf85263->intb_ie |= pcf85263_int_sources[j].ie;
+		pcf85263->intb_flags |= pcf85263_int_sources[j].flags;
+	}
+
+	return 0;
+}
+
+/*
+ * The periodic interrupt is shared by the IIO trigger and the PPS source.
+ * PPS needs a 1 Hz tick for as long as it is registered, so it wins over
+ * the trigger period. Must be called with pcf85263->lock held.
+ */
+static int pcf85263_update_periodic(struct pcf85263 *pcf85263)
+{
+	unsigned int pi = 0;
+	int ret;
+
+#if IS_ENABLED(CONFIG_IIO_TRIGGER)
+	if (pcf85263->trig_enabled)
+		pi = pcf85263->trig_pi;
+#endif
+#if IS_ENABLED(CONFIG_PPS)
+	if (pcf85263->pps)
+		pi = FUNC_PI_SEC;
+#endif
+
+	ret = regmap_update_bits(pcf85263->regmap, CTRL_FUNCTION, FUNC_PI,
+				 pi << FUNC_PI_SHIFT);
+	if (ret)
+		return ret;
+
+	return regmap_update_bits(pcf85263->regmap,
+				  pcf85263_int_reg(pcf85263, INT_PIE), INT_PIE,
+				  pi ? INT_PIE : 0);
+}
+
+#if IS_ENABLED(CONFIG_IIO_TRIGGER)
+/*
+ * The periodic interrupt as an IIO trigger: buffered IIO devices capture on
+ * every RTC tick, with the crystal as the timebase instead of an hrtimer.
+ */
+static const unsigned int trig_periods[] = {
+	[FUNC_PI_SEC] = 1,
+	[FUNC_PI_MIN] = 60,
+	[FUNC_PI_HOUR] = 3600,
+};
+
+static int pcf85263_trigger_set_state(struct iio_trigger *trig, bool state)
+{
+	struct pcf85263 *pcf85263 = iio_trigger_get_drvdata(trig);
+	int ret;
+
+	mutex_lock(&pcf85263->lock);
+	pcf85263->trig_enabled = state;
+	ret = pcf85263_update_periodic(pcf85263);
+	if (ret)
+		pcf85263->trig_enabled = !state;
+	mutex_unlock(&pcf85263->lock);
+
+	return ret;
+}
+
+static const struct iio_trigger_ops pcf85263_trigger_ops = {
+	.set_trigger_state = pcf85263_trigger_set_state,
+};
+
+static ssize_t tick_period_show(struct device *dev,
+				struct device_attribute *attr, char *buf)
+{
+	struct pcf85263 *pcf85263 = iio_trigger_get_drvdata(to_iio_trigger(dev));
+
+	return sprintf(buf, "%u\n", trig_periods[pcf85263->trig_pi]);
+}
+
+static ssize_t tick_period_store(struct device *dev,
+				 struct device_attribute *attr,
+				 const char *buf, size_t count)
+{
+	struct pcf85263 *pcf85263 = iio_trigger_get_drvdata(to_iio_trigger(dev));
+	unsigned int period, pi;
+	int ret;
+
+	ret = kstrtouint(buf, 0, &period);
+	if (ret)
+		return ret;
+
+	for (pi = FUNC_PI_SEC; pi < ARRAY_SIZE(trig_periods); pi++)
+		if (trig_periods[pi] == period)
+			break;
+	if (pi == ARRAY_SIZE(trig_periods))
+		return -EINVAL;
+
+	/* the check and the update as one, against a trigger enable */
+	mutex_lock(&pcf85263->lock);
+#if IS_ENABLED(CONFIG_PPS)
+	/* the PPS source pins the tick to once per second */
+	if (pcf85263->pps && pi != FUNC_PI_SEC)
+		ret = -EBUSY;
+#endif
+
+	if (!ret) {
+		pcf85263->trig_pi = pi;
+		if (pcf85263->trig_enabled)
+			ret = pcf85263_update_periodic(pcf85263);
+	}
+	mutex_unlock(&pcf85263->lock);
+
+	return ret ? ret : count;
+}
+
+static DEVICE_ATTR_RW(tick_period);
+
+static struct attribute *pcf85263_trigger_attrs[] = {
+	&dev_attr_tick_period.attr,
+	NULL,
+};
+
+ATTRIBUTE_GROUPS(pcf85263_trigger);
+
+static int pcf85263_trigger_register(struct device *dev,
+				     struct pcf85263 *pcf85263)
+{
+	struct iio_trigger *trig;
+
+	trig = devm_iio_trigger_alloc(dev, "%s-tick", dev_name(dev));
+	if (!trig)
+		return -ENOMEM;
+
+	trig->dev.parent = dev;
+	trig->dev.groups = pcf85263_trigger_groups;
+	trig->ops = &pcf85263_trigger_ops;
+	iio_trigger_set_drvdata(trig, pcf85263);
+	pcf85263->trig_pi = FUNC_PI_SEC;
+	pcf85263->trig = trig;
+
+	return devm_iio_trigger_register(dev, trig);
+}
+#endif
+
+#if IS_ENABLED(CONFIG_PPS)
+static void pcf85263_pps_unregister(void *data)
+{
+	pps_unregister_source(data);
+}
+
+static int pcf85263_pps_register(struct device *dev, struct pcf85263 *pcf85263)
+{
+	struct pps_source_info info = {
+		.mode = PPS_CAPTUREASSERT | PPS_OFFSETASSERT |
+			PPS_CANWAIT | PPS_TSFMT_TSPEC,
+		.owner = THIS_MODULE,
+		.dev = dev,
+	};
+	struct pps_device *pps;
+
+	snprintf(info.name, sizeof(info.name), "%s", dev_name(dev));
+	pps = pps_register_source(&info, PPS_CAPTUREASSERT | PPS_OFFSETASSERT);
+	if (IS_ERR_OR_NULL(pps))
+		return pps ? PTR_ERR(pps) : -ENOMEM;
+
+	spin_lock_init(&pcf85263->pps_lock);
+	mutex_lock(&pcf85263->lock);
+	pcf85263->pps = pps;
+	mutex_unlock(&pcf85263->lock);
+
+	return devm_add_action_or_reset(dev, pcf85263_pps_unregister, pps);
+}
+
+/*
+ * With PPS the periodic interrupt runs in pulse mode, where INTA pulses on
+ * every second edge whether or not PIF has been cleared. The edge is
+ * timestamped here, and unless the thread has to run anyway, for the IIO
+ * trigger or for another source on the line, the event is delivered
+ * without touching the bus at all. Otherwise the thread delivers it.
+ */
+static irqreturn_t pcf85263_rtc_irq_pulse(int irq, void *dev_id)
+{
+	struct pcf85263 *pcf85263 = dev_id;
+	struct pps_event_time ts;
+	bool wake = pcf85263->pps_shared;
+
+	pps_get_ts(&ts);
+
+#if IS_ENABLED(CONFIG_IIO_TRIGGER)
+	wake |= READ_ONCE(pcf85263->trig_enabled);
+#endif
+
+	if (!wake) {
+		pps_event(pcf85263->pps, &ts, PPS_CAPTUREASSERT, NULL);
+		return IRQ_HANDLED;
+	}
+
+	spin_lock(&pcf85263->pps_lock);
+	pcf85263->pps_ts = ts;
+	pcf85263->pps_pending = true;
+	spin_unlock(&pcf85263->pps_lock);
+
+	return IRQ_WAKE_THREAD;
+}
+
+/* The edge the hard handler left for the thread, if there is one */
+static bool pcf85263_pps_deliver(struct pcf85263 *pcf85263)
+{
+	struct pps_event_time ts;
+	bool pending;
+
+	if (!pcf85263->pps)
+		return false;
+
+	spin_lock_irq(&pcf85263->pps_lock);
+	ts = pcf85263->pps_ts;
+	pending = pcf85263->pps_pending;
+	pcf85263->pps_pending = false;
+	spin_unlock_irq(&pcf85263->pps_lock);
+
+	if (pending)
+		pps_event(pcf85263->pps, &ts, PPS_CAPTUREASSERT, NULL);
+
+	return pending;
+}
+#endif
+
+/*
+ * Each line only looks at the flags of its own sources, and clearing them
+ * leaves the other line's flags alone, so the two handlers never need to
+ * coordinate. The flags come with the time they were read at, which is
+ * kept as the time of the event.
+ */
+static irqreturn_t pcf85263_handle_flags(struct pcf85263 *pcf85263, u8 mask)
+{
+	unsigned char status[STATUS_SIZE];
+	unsigned int flags;
+	bool pulse = false;
+	int ret;
+
+#if IS_ENABLED(CONFIG_PPS)
+	pulse = pcf85263_pps_deliver(pcf85263);
+#endif
+
+	/* under the lock, or it can catch a set with the clock stopped */
+	mutex_lock(&pcf85263->lock);
+	ret = pcf85263_read_status(pcf85263, status);
+	mutex_unlock(&pcf85263->lock);
+	if (ret)
+		return pulse ? IRQ_HANDLED : IRQ_NONE;
+
+	flags = status[0] & mask;
+	if (!flags)
+		return pulse ? IRQ_HANDLED : IRQ_NONE;
+
+	/* flags clear on writing zero, writing one leaves them alone */
+	ret = regmap_write(pcf85263->regmap, CTRL_FLAGS, (u8)~flags);
+	if (ret)
+		return pulse ? IRQ_HANDLED : IRQ_NONE;
+
+	mutex_lock(&pcf85263->lock);
+	pcf85263->event_flags = flags;
+	pcf85263_status_to_ts(pcf85263, status, &pcf85263->event_ts);
+	mutex_unlock(&pcf85263->lock);
+
+#if IS_ENABLED(CONFIG_IIO_TRIGGER)
+	if (flags & FLAGS_PIF)
+		iio_trigger_poll_chained(pcf85263->trig);
+#endif
+
+	return IRQ_HANDLED;
+}
+
+static irqreturn_t pcf85263_rtc_handle_irq(int irq, void *dev_id)
+{
+	struct pcf85263 *pcf85263 = dev_id;
+
+	return pcf85263_handle_flags(pcf85263, ~pcf85263->intb_flags);
+}
+
+static irqreturn_t pcf85263_rtc_handle_irq_b(int irq, void *dev_id)
+{
+	struct pcf85263 *pcf85263 = dev_id;
+
+	return pcf85263_handle_flags(pcf85263, pcf85263->intb_flags);
+}
+
+/*
+ * Set up one interrupt line. The line carrying the periodic interrupt runs
+ * in pulse mode for PPS, the other stays a level interrupt held until its
+ * flags are cleared.
+ */
+static int pcf85263_request_line(struct device *dev, struct pcf85263 *pcf85263,
+				 int irq, unsigned int reg,
+				 irq_handler_t thread_fn, bool pulse)
+{
+	unsigned long irqflags = IRQF_TRIGGER_LOW | IRQF_ONESHOT;
+	irq_handler_t handler = NULL;
+	const char *name = dev_name(dev);
+	int ret;
+
+#if IS_ENABLED(CONFIG_PPS)
+	if (pulse) {
+		unsigned int ie;
+
+		irqflags = IRQF_TRIGGER_FALLING | IRQF_ONESHOT;
+		handler = pcf85263_rtc_irq_pulse;
+
+		/*
+		 * Sources the bootloader left on share the pulse line and
+		 * still need the thread. The driver enables none of its own.
+		 */
+		ret = regmap_read(pcf85263->regmap, reg, &ie);
+		if (ret)
+			return ret;
+		pcf85263->pps_shared = ie & ~(INT_ILP | INT_PIE);
+	}
+#endif
+
+	ret = regmap_update_bits(pcf85263->regmap, reg, INT_ILP | INT_PIE,
+				 pulse ? 0 : INT_ILP);
+	if (ret)
+		return ret;
+
+	if (reg == CTRL_INTB_EN) {
+		name = devm_kasprintf(dev, GFP_KERNEL, "%s-intb", dev_name(dev));
+		if (!name)
+			return -ENOMEM;
+	}
+
+	return devm_request_threaded_irq(dev, irq, handler, thread_fn,
+					 irqflags, name, pcf85263);
+}
+
+static int pcf85263_setup_irq(struct i2c_client *client,
+			      struct pcf85263 *pcf85263)
+{
+	struct device *dev = &client->dev;
+	unsigned int pin_io = PIN_IO_INTA_OUT;
+	bool pps = false;
+	int ret;
+
+	ret = pcf85263_init_routing(dev, pcf85263);
+	if (ret)
+		return ret;
+
+#if IS_ENABLED(CONFIG_PPS)
+	if (of_property_read_bool(dev->of_node, "nxp,pps")) {
+		ret = pcf85263_pps_register(dev, pcf85263);
+		if (ret)
+			return ret;
+		pps = true;
+	}
+#endif
+
+	/* INTB shares its pin with TS, which becomes an output */
+	if (pcf85263->irq_b)
+		pin_io |= PIN_IO_TSPM_INTB;
+
+	ret = regmap_update_bits(pcf85263->regmap, CTRL_PIN_IO,
+				 PIN_IO_INTAPM | PIN_IO_TSPM, pin_io);
+	if (ret)
+		return ret;
+
+	ret = regmap_write(pcf85263->regmap, CTRL_FLAGS, (u8)~FLAGS_PIF);
+	if (ret)
+		return ret;
+
+#if IS_ENABLED(CONFIG_IIO_TRIGGER)
+	ret = pcf85263_trigger_register(dev, pcf85263);
+	if (ret)
+		return ret;
+#endif
+
+	/* an "intb" only description leaves INTA unconnected */
+	if (client->irq != pcf85263->irq_b) {
+		ret = pcf85263_request_line(dev, pcf85263, client->irq,
+					    CTRL_INTA_EN,
+					    pcf85263_rtc_handle_irq,
+					    pps && !(pcf85263->intb_ie & INT_PIE));
+		if (ret)
+			return ret;
+	}
+
+	if (pcf85263->irq_b) {
+		ret = pcf85263_request_line(dev, pcf85263, pcf85263->irq_b,
+					    CTRL_INTB_EN,
+					    pcf85263_rtc_handle_irq_b,
+					    pps && (pcf85263->intb_ie & INT_PIE));
+		if (ret)
+			return ret;
+	}
+
+	mutex_lock(&pcf85263->lock);
+	ret = pcf85263_update_periodic(pcf85263);
+	mutex_unlock(&pcf85263->lock);
+
+	return ret;
+}
+
+#ifdef CONFIG_PM_SLEEP
+#ifdef PCF85263_SLEEPTIME
+/*
+ * Sleep time accounting with hundredths. The rtc core only injects whole
+ * seconds, which loses up to a second per suspend cycle; injecting the
+ * sub-second delta from here first makes the core skip its own.
+ */
+
+static void pcf85263_suspend_sleeptime(struct pcf85263 *pcf85263)
+{
+	pcf85263->suspend_valid = false;
+	if (!pcf85263->inject_sleeptime || pcf85263->stopwatch ||
+	    timekeeping_rtc_skipsuspend())
+		return;
+
+	if (!pcf85263_read_ts64(pcf85263, &pcf85263->suspend_ts,
+				pcf85263->sleeptime_align))
+		pcf85263->suspend_valid = true;
+}
+
+static void pcf85263_resume_sleeptime(struct pcf85263 *pcf85263)
+{
+	struct timespec64 now, delta;
+
+	/* nothing to do if a persistent or suspend clock already did it */
+	if (!pcf85263->suspend_valid || timekeeping_rtc_skipresume())
+		return;
+
+	if (pcf85263_read_ts64(pcf85263, &now, pcf85263->sleeptime_align))
+		return;
+
+	delta = timespec64_sub(now, pcf85263->suspend_ts);
+	if (delta.tv_sec < 0)
+		return;
+
+	timekeeping_inject_sleeptime64(&delta);
+}
+
+static void pcf85263_init_sleeptime(struct device *dev,
+				    struct pcf85263 *pcf85263)
+{
+	/* take over from the rtc core when it would use this device */
+	pcf85263->inject_sleeptime =
+		!strcmp(dev_name(&pcf85263->rtc->dev),
+			CONFIG_RTC_HCTOSYS_DEVICE) ||
+		of_property_read_bool(dev->of_node, "nxp,inject-sleeptime");
+	pcf85263->sleeptime_align =
+		of_property_read_bool(dev->of_node, "nxp,sleeptime-align");
+}
+
+#else
+static void pcf85263_suspend_sleeptime(struct pcf85263 *pcf85263) { }
+static void pcf85263_resume_sleeptime(struct pcf85263 *pcf85263) { }
+#endif /* PCF85263_SLEEPTIME */
+
+static int pcf85263_suspend(struct device *dev)
+{
+	pcf85263_suspend_sleeptime(dev_get_drvdata(dev));
+
+	return 0;
+}
+
+static int pcf85263_resume(struct device *dev)
+{
+	struct pcf85263 *pcf85263 = dev_get_drvdata(dev);
+	int ret;
+
+	/* the sleep time first, the sample should be close to the wakeup */
+	pcf85263_resume_sleeptime(pcf85263);
+
+	/*
+	 * A backup supply that dropped out while suspended resets the chip.
+	 * The profile and the compensated offset are written out from the
+	 * cache whether or not it did, regcache_sync() would only write
+	 * registers marked dirty.
+	 */
+	mutex_lock(&pcf85263->lock);
+	ret = pcf85263_apply_profile(pcf85263);
+	if (!ret && pcf85263->tc.zone)
+		ret = regmap_write(pcf85263->regmap, CTRL_OFFSET,
+				   (u8)pcf85263->tc.offset);
+	mutex_unlock(&pcf85263->lock);
+	if (ret)
+		dev_warn(dev, "unable to restore power profile: %d\n", ret);
+
+	return 0;
+}
+
+static SIMPLE_DEV_PM_OPS(pcf85263_pm_ops, pcf85263_suspend, pcf85263_resume);
+#define PCF85263_PM_OPS	(&pcf85263_pm_ops)
+#else
+#define PCF85263_PM_OPS	NULL
+#endif
+
+/*
+ * Registers the chip changes on its own, or that are commands, are never
+ * cached. The RAM stays uncached so nvmem transfers go straight to the bus.
+ */
+static bool pcf85263_volatile_reg(struct device *dev, unsigned int reg)
+{
+	switch (reg) {
+	case DT_100THS ... DT_YEARS:
+	case DT_TIMESTAMP1 ... DT_TS_MODE - 1:
+	case CTRL_FLAGS:
+	case CTRL_RAMBYTE:
+	case CTRL_WDOG:
+	case CTRL_RESETS:
+		return true;
+	}
+
+	return reg >= CTRL_RAM;
+}
+
+static bool pcf85063_volatile_reg(struct device *dev, unsigned int reg)
+{
+	switch (reg) {
+	case PCF85063_CTRL2:
+	case PCF85063_RAMBYTE:
+	case PCF85063_DT_SECS ... PCF85063_DT_YEARS:
+	case PCF85063A_TIMER_VALUE:
+		return true;
+	}
+
+	return false;
+}
+
+/* The whole time and control space in one auto-incrementing read */
+static int pcf85263_read_snapshot(struct i2c_client *client,
+				  unsigned char *regs, unsigned int len)
+{
+	unsigned char reg = DT_100THS;
+	struct i2c_msg msgs[] = {
+		{
+			.addr = client->addr,
+			.len = 1,
+			.buf = &reg,
+		}, {
+			.addr = client->addr,
+			.flags = I2C_M_RD,
+			.len = len,
+			.buf = regs,
+		},
+	};
+	int ret;
+
+	ret = i2c_transfer(client->adapter, msgs, ARRAY_SIZE(msgs));
+	if (ret < 0)
+		return ret;
+
+	return ret == ARRAY_SIZE(msgs) ? 0 : -EIO;
+}
+
+/*
+ * Check the probe snapshot and put right what the driver cannot live with:
+ * a clock left stopped by an interrupted set, or INTA sources enabled with
+ * nobody to service them. Everything else is reported in one line.
+ */
+static int pcf85263_check_health(struct i2c_client *client,
+				 struct pcf85263 *pcf85263,
+				 const unsigned char *regs)
+{
+	const struct pcf85263_variant *variant = pcf85263->variant;
+	const struct pcf85263_layout *layout = variant->layout;
+	unsigned char secs = regs[layout->dt_reg + DT_SECS - layout->dt_skip];
+	/* as captured, before any switch to 24-hour mode */
+	bool h12 = regs[variant->hour_mode_reg] & variant->hour_mode_12h;
+	struct device *dev = &client->dev;
+	int ret;
+
+	if (regs[layout->stop_reg] & layout->stop_bit) {
+		dev_warn(dev, "clock was left stopped, restarting\n");
+		ret = regmap_update_bits(pcf85263->regmap, layout->stop_reg,
+					 layout->stop_bit, 0);
+		if (ret)
+			return ret;
+	}
+
+	if (!(variant->features & PCF_FEAT_INTAB)) {
+		dev_info(dev, "health: osc %s, %s, offset %d\n",
+			 secs & SECS_OS ? "stopped" : "ok",
+			 h12 ? "12h" : "24h", (s8)regs[variant->offset_reg]);
+		return 0;
+	}
+
+	if (client->irq <= 0 && (regs[CTRL_INTA_EN] & ~INT_ILP)) {
+		ret = regmap_update_bits(pcf85263->regmap, CTRL_INTA_EN,
+					 (u8)~INT_ILP, 0);
+		if (ret)
+			return ret;
+	}
+
+	dev_info(dev,
+		 "health: osc %s, %s mode, %s, flags %#04x, inta %#04x, intb %#04x, pin_io %#04x, offset %d\n",
+		 secs & SECS_OS ? "stopped" : "ok",
+		 regs[CTRL_FUNCTION] & FUNC_RTCM ? "stopwatch" : "rtc",
+		 h12 ? "12h" : "24h",
+		 regs[CTRL_FLAGS], regs[CTRL_INTA_EN], regs[CTRL_INTB_EN],
+		 regs[CTRL_PIN_IO], (s8)regs[CTRL_OFFSET]);
+
+	return 0;
+}
+
+#define PCF85263_FEATURES	(PCF_FEAT_100THS | PCF_FEAT_ALARM1 | \
+				 PCF_FEAT_ALARM2 | PCF_FEAT_TIMESTAMPS | \
+				 PCF_FEAT_STOPWATCH | PCF_FEAT_INTAB)
+
+static const struct pcf85263_variant pcf85263_variant = {
+	.layout = &pcf85263_layout,
+	.rtc_ops = &pcf85263_rtc_ops,
+	.regmap = {
+		.reg_bits = 8,
+		.val_bits = 8,
+		.max_register = CTRL_RESETS,
+		.volatile_reg = pcf85263_volatile_reg,
+	},
+	.features = PCF85263_FEATURES,
+	.num_regs = CTRL_RESETS + 1,
+	.rambyte_reg = CTRL_RAMBYTE,
+	.offset_reg = CTRL_OFFSET,
+	.hour_mode_reg = CTRL_OSCILLATOR,
+	.hour_mode_12h = OSC_12_24,
+	.cof_reg = CTRL_FUNCTION,
+};
+
+static const struct pcf85263_variant pcf85363_variant = {
+	.layout = &pcf85263_layout,
+	.rtc_ops = &pcf85263_rtc_ops,
+	.regmap = {
+		.reg_bits = 8,
+		.val_bits = 8,
+		.max_register = CTRL_RAM + RAM_SIZE - 1,
+		.volatile_reg = pcf85263_volatile_reg,
+	},
+	.features = PCF85263_FEATURES,
+	.num_regs = CTRL_RESETS + 1,
+	.ram_size = RAM_SIZE,
+	.rambyte_reg = CTRL_RAMBYTE,
+	.offset_reg = CTRL_OFFSET,
+	.hour_mode_reg = CTRL_OSCILLATOR,
+	.hour_mode_12h = OSC_12_24,
+	.cof_reg = CTRL_FUNCTION,
+};
+
+static const struct pcf85263_variant pcf85063a_variant = {
+	.layout = &pcf85063_layout,
+	.rtc_ops = &pcf85063_rtc_ops,
+	.regmap = {
+		.reg_bits = 8,
+		.val_bits = 8,
+		.max_register = PCF85063A_TIMER_MODE,
+		.volatile_reg = pcf85063_volatile_reg,
+	},
+	.features = PCF_FEAT_ALARM1,
+	.num_regs = PCF85063A_TIMER_MODE + 1,
+	.rambyte_reg = PCF85063_RAMBYTE,
+	.offset_reg = PCF85063_OFFSET,
+	.hour_mode_reg = PCF85063_CTRL1,
+	.hour_mode_12h = PCF85063_CTRL1_12_24,
+	.cof_reg = PCF85063_CTRL2,
+};
+
+static const struct pcf85263_variant pcf85063tp_variant = {
+	.layout = &pcf85063_layout,
+	.rtc_ops = &pcf85063_rtc_ops,
+	.regmap = {
+		.reg_bits = 8,
+		.val_bits = 8,
+		.max_register = PCF85063_DT_YEARS,
+		.volatile_reg = pcf85063_volatile_reg,
+	},
+	.num_regs = PCF85063_DT_YEARS + 1,
+	.rambyte_reg = PCF85063_RAMBYTE,
+	.offset_reg = PCF85063_OFFSET,
+	.hour_mode_reg = PCF85063_CTRL1,
+	.hour_mode_12h = PCF85063_CTRL1_12_24,
+	.cof_reg = PCF85063_CTRL2,
+};
+
+/*
+ * Probe runs asynchronously, off the boot thread. Everything up to the rtc
+ * registration is what hctosys needs, and a failure there fails the probe;
+ * nvmem, the time page, interrupts and the clock output are set up after
+ * it, and a failure in those is reported with the rtc left working.
+ */
+static int pcf85263_probe(struct i2c_client *client,
+			  const struct i2c_device_id *id)
+{
+	struct reg_default reg_defaults[SNAPSHOT_SIZE];
+	unsigned char regs[SNAPSHOT_SIZE];
+	const struct pcf85263_variant *variant;
+	struct regmap_config regmap_config;
+	struct pcf85263 *pcf85263;
+	unsigned int reg, n = 0;
+	u64 boot_ns;
+	int ret;
+
+	if (!i2c_check_functionality(client->adapter, I2C_FUNC_I2C))
+		return -ENODEV;
+
+	pcf85263 = devm_kzalloc(&client->dev, sizeof(struct pcf85263),
+				GFP_KERNEL);
+	if (!pcf85263)
+		return -ENOMEM;
+
+	mutex_init(&pcf85263->lock);
+	variant = device_get_match_data(&client->dev);
+	if (!variant && id)
+		variant = (const struct pcf85263_variant *)id->driver_data;
+	if (!variant)
+		return -ENODEV;
+	pcf85263->variant = variant;
+	pcf85263->client = client;
+
+	ret = pcf85263_read_snapshot(client, regs, variant->num_regs);
+	if (ret) {
+		dev_err(&client->dev, "unable to read registers: %d\n", ret);
+		return ret;
+	}
+	boot_ns = ktime_get_boot_ns();
+
+	/* the snapshot seeds the register cache, so no read is repeated */
+	regmap_config = variant->regmap;
+	regmap_config.cache_type = REGCACHE_RBTREE;
+	for (reg = 0; reg < variant->num_regs; reg++) {
+		if (regmap_config.volatile_reg(&client->dev, reg))
+			continue;
+		reg_defaults[n].reg = reg;
+		reg_defaults[n].def = regs[reg];
+		n++;
+	}
+	regmap_config.reg_defaults = reg_defaults;
+	regmap_config.num_reg_defaults = n;
+
+	pcf85263->regmap = devm_regmap_init_i2c(client, &regmap_config);
+	if (IS_ERR(pcf85263->regmap)) {
+		dev_err(&client->dev, "regmap allocation failed\n");
+		return PTR_ERR(pcf85263->regmap);
+	}
+
+	i2c_set_clientdata(client, pcf85263);
+
+	pcf85263_set_hour_mode(&pcf85263->hours,
+			       regs[variant->hour_mode_reg] &
+			       variant->hour_mode_12h);
+
+	/* before the rtc registers, so hctosys never reads a stopped clock */
+	ret = pcf85263_check_health(client, pcf85263, regs);
+	if (ret) {
+		dev_err(&client->dev, "health check failed: %d\n", ret);
+		return ret;
+	}
+
+	ret = pcf85263_init_mode(&client->dev, pcf85263);
+	if (ret) {
+		dev_err(&client->dev, "unable to set up mode: %d\n", ret);
+		return ret;
+	}
+
+	ret = pcf85263_normalize_24h(&client->dev, pcf85263);
+	if (ret) {
+		dev_err(&client->dev, "unable to set 24-hour mode: %d\n", ret);
+		return ret;
+	}
+
+	ret = pcf85263_init_meta(&client->dev, pcf85263);
+	if (ret) {
+		dev_err(&client->dev, "unable to load metadata: %d\n", ret);
+		return ret;
+	}
+
+	ret = pcf85263_init_century(&client->dev, pcf85263);
+	if (ret) {
+		dev_err(&client->dev, "unable to read century: %d\n", ret);
+		return ret;
+	}
+
+	ret = pcf85263_init_boot(&client->dev, pcf85263, regs, boot_ns);
+	if (ret) {
+		dev_err(&client->dev, "unable to set up boot timing: %d\n", ret);
+		return ret;
+	}
+
+	ret = pcf85263_init_tc(&client->dev, pcf85263, regs);
+	if (ret) {
+		dev_err(&client->dev,
+			"unable to set up temperature compensation: %d\n", ret);
+		return ret;
+	}
+
+	/* after the compensation, which adds OFFM to the profile */
+	ret = pcf85263_init_profile(&client->dev, pcf85263);
+	if (ret) {
+		dev_err(&client->dev, "unable to set power profile: %d\n", ret);
+		return ret;
+	}
+
+	ret = pcf85263_init_page(&client->dev, pcf85263);
+	if (ret) {
+		dev_err(&client->dev, "unable to set up time page: %d\n", ret);
+		return ret;
+	}
+
+	pcf85263->rtc = devm_rtc_allocate_device(&client->dev);
+	if (IS_ERR(pcf85263->rtc))
+		return PTR_ERR(pcf85263->rtc);
+
+	pcf85263->rtc->ops = variant->rtc_ops;
+	pcf85263->rtc->range_min = RTC_TIMESTAMP_BEGIN_2000;
+	pcf85263->rtc->range_max = pcf85263->century_en ? CENTURY_END :
+				   RTC_TIMESTAMP_END_2099;
+
+	ret = rtc_register_device(pcf85263->rtc);
+	if (ret)
+		return ret;
+
+	ret = devm_device_add_group(&client->dev, &pcf85263_attr_group);
+	if (ret)
+		return ret;
+
+#ifdef PCF85263_SLEEPTIME
+	pcf85263_init_sleeptime(&client->dev, pcf85263);
+#endif
+
+	ret = pcf85263_register_nvmem(&client->dev, pcf85263);
+	if (ret)
+		dev_err(&client->dev, "unable to register nvmem: %d\n", ret);
+
+	if (pcf85263->page) {
+		ret = pcf85263_register_page(&client->dev, pcf85263);
+		if (ret)
+			dev_err(&client->dev,
+				"unable to register time page: %d\n", ret);
+	}
+
+	if (pcf85263->tc.zone)
+		schedule_delayed_work(&pcf85263->tc.work, 0);
+
+	if (client->irq > 0 && (variant->features & PCF_FEAT_INTAB)) {
+		ret = pcf85263_setup_irq(client, pcf85263);
+		if (ret)
+			dev_err(&client->dev, "unable to set up irq %d: %d\n",
+				client->irq, ret);
+	}
+
+#ifdef CONFIG_COMMON_CLK
+	if (!pcf85263->no_clkout) {
+		ret = pcf85263_clkout_register(client, pcf85263);
+		if (ret)
+			dev_warn(&client->dev, "unable to register clkout: %d\n",
+				 ret);
+	}
+#endif
+
+	return 0;
+}
+
+static const struct i2c_device_id dev_ids[] = {
+	{ "pcf85263", (unsigned long)&pcf85263_variant },
+	{ "pcf85363", (unsigned long)&pcf85363_variant },
+	{ "pcf85063a", (unsigned long)&pcf85063a_variant },
+	{ "pcf85063tp", (unsigned long)&pcf85063tp_variant },
+	{ }
+};
+
+MODULE_DEVICE_TABLE(i2c, dev_ids);
+
+/* ACPI platforms match these through PRP0001 and a _DSD compatible */
+static const struct of_device_id dev_ids_of[] = {
+	{ .compatible = "nxp,pcf85263", .data = &pcf85263_variant },
+	{ .compatible = "nxp,pcf85363", .data = &pcf85363_variant },
+	{ .compatible = "nxp,pcf85063a", .data = &pcf85063a_variant },
+	{ .compatible = "nxp,pcf85063tp", .data = &pcf85063tp_variant },
+	{ }
+};
+
+MODULE_DEVICE_TABLE(of, dev_ids_of);
+
+static struct i2c_driver pcf85263_driver = {
+	.driver	= {
+		.name	= "pcf85263",
+		.of_match_table = of_match_ptr(dev_ids_of),
+		.pm	= PCF85263_PM_OPS,
+		.probe_type = PROBE_PREFER_ASYNCHRONOUS,
+	},
+	.probe		= pcf85263_probe,
+	.shutdown	= pcf85263_shutdown,
+	.id_table 	= dev_ids,
+};
+
+#ifndef MODULE
+/*
+ * Early time for a built-in driver: a chip with nxp,early-hctosys sets the
+ * system clock, with hundredths, as soon as its adapter adds it, long
+ * before the rtc class and hctosys are up. A bus notifier sees the client
+ * as it is added, and the time block, hour mode and century byte come in
+ * one combined transfer. Drift correction needs the RAM metadata and is
+ * left to the full driver, which still probes and registers as usual.
+ */
+static int __init pcf85263_early_read(struct i2c_client *client)
+{
+	const struct pcf85263_variant *variant;
+	const struct pcf85263_layout *layout;
+	const struct of_device_id *match;
+	struct device_node *np = client->dev.of_node;
+	unsigned char buf[DT_YEARS + 1];
+	unsigned char ctrl[CTRL_FUNCTION - CTRL_OSCILLATOR + 1];
+	unsigned char regs[3], century = 0;
+	struct i2c_msg msgs[6] = {
+		{
+			.addr = client->addr,
+			.len = 1,
+			.buf = &regs[0],
+		}, {
+			.addr = client->addr,
+			.flags = I2C_M_RD,
+			.buf = buf,
+		}, {
+			.addr = client->addr,
+			.len = 1,
+			.buf = &regs[1],
+		}, {
+			.addr = client->addr,
+			.flags = I2C_M_RD,
+			.len = 1,
+			.buf = ctrl,
+		}, {
+			.addr = client->addr,
+			.len = 1,
+			.buf = &regs[2],
+		}, {
+			.addr = client->addr,
+			.flags = I2C_M_RD,
+			.len = 1,
+			.buf = &century,
+		},
+	};
+	struct pcf85263_hours hours;
+	struct timespec64 ts;
+	struct rtc_time tm;
+	bool stopwatch;
+	int n, ret;
+
+	match = of_match_node(dev_ids_of, np);
+	if (!match || !of_property_read_bool(np, "nxp,early-hctosys"))
+		return 0;
+
+	/* a persistent clock or an earlier chip got there first */
+	if (ktime_get_real_seconds() >= RTC_TIMESTAMP_BEGIN_2000)
+		return 0;
+
+	variant = match->data;
+	layout = variant->layout;
+
+	regs[0] = layout->dt_reg;
+	regs[1] = variant->hour_mode_reg;
+	regs[2] = variant->rambyte_reg;
+	buf[DT_100THS] = 0;
+	msgs[1].buf = buf + layout->dt_skip;
+	msgs[1].len = DT_YEARS + 1 - layout->dt_skip;
+	/* on a part with a stopwatch, on to CTRL_FUNCTION for the mode */
+	if (variant->features & PCF_FEAT_STOPWATCH)
+		msgs[3].len = sizeof(ctrl);
+	n = of_property_read_bool(np, "nxp,century-byte") ? 6 : 4;
+
+	ret = i2c_transfer(client->adapter, msgs, n);
+	if (ret != n)
+		return ret < 0 ? ret : -EIO;
+
+	stopwatch = (variant->features & PCF_FEAT_STOPWATCH) &&
+		    (ctrl[CTRL_FUNCTION - CTRL_OSCILLATOR] & FUNC_RTCM);
+	if (stopwatch || buf[DT_SECS] & SECS_OS)
+		return -EINVAL;
+
+	pcf85263_set_hour_mode(&hours, ctrl[0] & variant->hour_mode_12h);
+	if (!pcf85263_century_valid(century))
+		century = 0;
+	__pcf85263_regs_to_tm(&hours, century, buf, &tm);
+
+	/* the middle of the last tick, as hctosys does for whole seconds */
+	ts.tv_sec = rtc_tm_to_time64(&tm);
+	if (variant->features & PCF_FEAT_100THS)
+		ts.tv_nsec = bcd2bin(buf[DT_100THS]) * 10 * NSEC_PER_MSEC +
+			     5 * NSEC_PER_MSEC;
+	else
+		ts.tv_nsec = NSEC_PER_SEC >> 1;
+
+	ret = do_settimeofday64(&ts);
+	if (ret)
+		return ret;
+
+	dev_info(&client->dev, "early system time %lld.%02ld\n",
+		 (long long)ts.tv_sec, ts.tv_nsec / (10 * NSEC_PER_MSEC));
+
+	return 0;
+}
+
+static int __init pcf85263_early_dev(struct device *dev, void *data)
+{
+	struct i2c_client *client = i2c_verify_client(dev);
+	int ret;
+
+	if (!client)
+		return 0;
+
+	ret = pcf85263_early_read(client);
+	if (ret)
+		dev_warn(dev, "no early system time: %d\n", ret);
+
+	return 0;
+}
+
+static int __init pcf85263_early_notify(struct notifier_block *nb,
+					unsigned long action, void *data)
+{
+	if (action == BUS_NOTIFY_ADD_DEVICE)
+		pcf85263_early_dev(data, NULL);
+
+	return NOTIFY_DONE;
+}
+
+static struct notifier_block pcf85263_early_nb __initdata = {
+	.notifier_call = pcf85263_early_notify,
+};
+
+/* after i2c_init, before the usual subsys_initcall adapter drivers */
+static int __init pcf85263_early_init(void)
+{
+	int ret;
+
+	ret = bus_register_notifier(&i2c_bus_type, &pcf85263_early_nb);
+	if (ret)
+		return ret;
+
+	/* and any client that was already there */
+	return bus_for_each_dev(&i2c_bus_type, NULL, NULL, pcf85263_early_dev);
+}
+arch_initcall(pcf85263_early_init);
+
+/* the init text goes away after this */
+static int __init pcf85263_early_exit(void)
+{
+	return bus_unregister_notifier(&i2c_bus_type, &pcf85263_early_nb);
+}
+late_initcall_sync(pcf85263_early_exit);
+#endif /* !MODULE */
+
+/*
+ * Redundant RTC group: several chips named by phandle in one DT node,
+ * exposed as a single RTC. A read samples every member in one combined
+ * transfer per bus and returns the median, so one bad chip cannot move
+ * the group time. A set stops every member, writes them all and then
+ * starts them back to back, a few hundred microseconds apart at 100 kHz.
+ *
+ *	rtc-group {
+ *		compatible = "nxp,pcf85263-group";
+ *		nxp,rtcs = <&rtc0 &rtc1 &rtc2>;
+ *		nxp,max-skew-ms = <20>;
+ *	};
+ */
+#define GROUP_MAX	4
+#define GROUP_SKEW_MS	20
+#define GROUP_DIFF_MAX	(24 * 3600)	/* s */
+
+enum {
+	GROUP_UNKNOWN,
+	GROUP_OK,
+	GROUP_OUTLIER,
+	GROUP_INVALID,	/* read failed, oscillator stopped or stopwatch */
+};
+
+static const char * const pcf85263_group_states[] = {
+	"unknown", "ok", "outlier", "invalid",
+};
+
+struct pcf85263_group_member {
+	struct pcf85263		*pcf85263;
+	int			state;
+	s64			offset_ms;	/* from the median */
+	struct timespec64	ts;		/* at the group reference */
+};
+
+struct pcf85263_group {
+	struct device		*dev;
+	struct rtc_device	*rtc;
+	struct mutex		lock;
+	unsigned int		num;
+	unsigned int		max_skew_ms;
+	struct pcf85263_group_member members[GROUP_MAX];
+};
+
+static void pcf85263_group_lock(struct pcf85263_group *group)
+{
+	unsigned int i;
+
+	mutex_lock(&group->lock);
+	for (i = 0; i < group->num; i++)
+		mutex_lock_nested(&group->members[i].pcf85263->lock, i);
+}
+
+static void pcf85263_group_unlock(struct pcf85263_group *group)
+{
+	unsigned int i = group->num;
+
+	while (i--)
+		mutex_unlock(&group->members[i].pcf85263->lock);
+	mutex_unlock(&group->lock);
+}
+
+/*
+ * Read the members from first to last - 1 in one transfer, all on the same
+ * bus, and bring each reading back to ref. A member is sampled when its
+ * read starts, so its instant is interpolated over the transfer by the
+ * bytes sent before it.
+ */
+static void pcf85263_group_sample(struct pcf85263_group *group,
+				  unsigned int first, unsigned int last,
+				  u64 ref)
+{
+	struct i2c_msg msgs[2 * GROUP_MAX];
+	unsigned char regs[GROUP_MAX];
+	unsigned char buf[GROUP_MAX][DT_YEARS + 1];
+	unsigned int bytes[GROUP_MAX];
+	unsigned int i, k, n = 0, total = 0;
+	u64 start, end;
+	int ret;
+
+	for (i = first; i < last; i++) {
+		struct pcf85263 *pcf85263 = group->members[i].pcf85263;
+		const struct pcf85263_layout *layout = pcf85263->variant->layout;
+		struct i2c_client *client = pcf85263->client;
+
+		if (pcf85263->stopwatch) {
+			group->members[i].state = GROUP_INVALID;
+			continue;
+		}
+
+		regs[n] = layout->dt_reg;
+		buf[n][DT_100THS] = 0;
+		msgs[2 * n].addr = client->addr;
+		msgs[2 * n].flags = 0;
+		msgs[2 * n].len = 1;
+		msgs[2 * n].buf = &regs[n];
+		msgs[2 * n + 1].addr = client->addr;
+		msgs[2 * n + 1].flags = I2C_M_RD;
+		msgs[2 * n + 1].len = DT_YEARS + 1 - layout->dt_skip;
+		msgs[2 * n + 1].buf = buf[n] + layout->dt_skip;
+
+		/* address and register out, address for the read */
+		total += 3;
+		bytes[n] = total;
+		total += msgs[2 * n + 1].len;
+		n++;
+	}
+	if (!n)
+		return;
+
+	start = ktime_get_ns();
+	ret = i2c_transfer(group->members[first].pcf85263->client->adapter,
+			   msgs, 2 * n);
+	end = ktime_get_ns();
+
+	for (k = 0, i = first; i < last; i++) {
+		struct pcf85263_group_member *m = &group->members[i];
+		struct pcf85263 *pcf85263 = m->pcf85263;
+		struct rtc_time tm;
+		u64 at;
+
+		if (pcf85263->stopwatch)
+			continue;
+
+		if (ret != 2 * n || buf[k][DT_SECS] & SECS_OS) {
+			m->state = GROUP_INVALID;
+			k++;
+			continue;
+		}
+
+		if (pcf85263_regs_to_tm(pcf85263, buf[k], &tm))
+			pcf85263_leap_fix(pcf85263, buf[k], &tm,
+					  pcf85263->variant->layout);
+		else if (pcf85263->century_en)
+			pcf85263_century_store(pcf85263, &tm);
+		m->ts.tv_sec = rtc_tm_to_time64(&tm);
+		if (pcf85263->drift)
+			m->ts.tv_sec = pcf85263_drift_correct(pcf85263,
+							      m->ts.tv_sec);
+		m->ts.tv_nsec = bcd2bin(buf[k][DT_100THS]) * 10 * NSEC_PER_MSEC;
+
+		at = start + div_u64((end - start) * bytes[k], total);
+		m->ts = timespec64_sub(m->ts, ns_to_timespec64(at - ref));
+		m->state = GROUP_OK;
+		k++;
+	}
+}
+
+static int pcf85263_group_cmp(const void *a, const void *b)
+{
+	return timespec64_compare(a, b);
+}
+
+/* Difference in ms, saturating at a day, far past any max_skew_ms */
+static s64 pcf85263_group_diff_ms(const struct timespec64 *a,
+				  const struct timespec64 *b)
+{
+	struct timespec64 d = timespec64_sub(*a, *b);
+
+	d.tv_sec = clamp_t(time64_t, d.tv_sec, -GROUP_DIFF_MAX, GROUP_DIFF_MAX);
+
+	return d.tv_sec * MSEC_PER_SEC + d.tv_nsec / NSEC_PER_MSEC;
+}
+
+static int pcf85263_group_read_time(struct device *dev, struct rtc_time *tm)
+{
+	struct pcf85263_group *group = dev_get_drvdata(dev);
+	struct timespec64 sorted[GROUP_MAX], median;
+	unsigned int i, last, n = 0;
+	u64 ref;
+
+	pcf85263_group_lock(group);
+
+	/* one transfer per run of members on the same bus */
+	ref = ktime_get_ns();
+	for (i = 0; i < group->num; i = last) {
+		struct i2c_adapter *adap =
+			group->members[i].pcf85263->client->adapter;
+
+		for (last = i + 1; last < group->num; last++)
+			if (group->members[last].pcf85263->client->adapter !=
+			    adap)
+				break;
+		pcf85263_group_sample(group, i, last, ref);
+	}
+
+	for (i = 0; i < group->num; i++)
+		if (group->members[i].state == GROUP_OK)
+			sorted[n++] = group->members[i].ts;
+
+	if (!n) {
+		pcf85263_group_unlock(group);
+		dev_warn_ratelimited(dev, "no member has a valid time\n");
+		return -EINVAL;
+	}
+
+	/* the lower median, so it is always a real reading */
+	sort(sorted, n, sizeof(sorted[0]), pcf85263_group_cmp, NULL);
+	median = sorted[(n - 1) / 2];
+
+	for (i = 0; i < group->num; i++) {
+		struct pcf85263_group_member *m = &group->members[i];
+
+		if (m->state != GROUP_OK)
+			continue;
+		m->offset_ms = pcf85263_group_diff_ms(&m->ts, &median);
+		if (abs(m->offset_ms) > group->max_skew_ms) {
+			m->state = GROUP_OUTLIER;
+			dev_warn_ratelimited(dev, "%s is %lld ms off the group\n",
+					     dev_name(&m->pcf85263->client->dev),
+					     m->offset_ms);
+		}
+	}
+
+	pcf85263_group_unlock(group);
+
+	/* and on to now, the median is of readings at ref */
+	median = timespec64_add(median,
+				ns_to_timespec64(ktime_get_ns() - ref));
+	rtc_time64_to_tm(median.tv_sec, tm);
+
+	return 0;
+}
+
+static int pcf85263_group_set_time(struct device *dev, struct rtc_time *tm)
+{
+	struct pcf85263_group *group = dev_get_drvdata(dev);
+	unsigned char buf[GROUP_MAX][DT_YEARS + 1];
+	struct pcf85263 *pcf85263;
+	unsigned int i, stopped;
+	int ret = 0, err;
+
+	pcf85263_group_lock(group);
+
+	for (i = 0; i < group->num; i++) {
+		if (group->members[i].pcf85263->stopwatch) {
+			ret = -EBUSY;
+			goto out;
+		}
+	}
+
+	/* everything but the writes themselves is done before any stop */
+	for (i = 0; i < group->num; i++) {
+		pcf85263 = group->members[i].pcf85263;
+		pcf85263_tm_to_regs(pcf85263, tm, buf[i]);
+		if (pcf85263->drift)
+			pcf85263_drift_update(pcf85263, rtc_tm_to_time64(tm));
+	}
+
+	for (stopped = 0; stopped < group->num; stopped++) {
+		pcf85263 = group->members[stopped].pcf85263;
+		ret = __pcf85263_stop(pcf85263, pcf85263->variant->layout);
+		if (ret)
+			goto start;
+	}
+
+	for (i = 0; i < group->num; i++) {
+		pcf85263 = group->members[i].pcf85263;
+		ret = __pcf85263_write_dt(pcf85263, buf[i],
+					  pcf85263->variant->layout);
+		if (ret)
+			goto start;
+	}
+
+start:
+	/* even after an error, nothing is left stopped */
+	for (i = 0; i < stopped; i++) {
+		pcf85263 = group->members[i].pcf85263;
+		err = __pcf85263_start(pcf85263, pcf85263->variant->layout);
+		if (err && !ret)
+			ret = err;
+		if (pcf85263->page)
+			pcf85263_page_publish(pcf85263, NULL, 0);
+	}
+	if (ret)
+		goto out;
+
+	for (i = 0; i < group->num; i++) {
+		pcf85263 = group->members[i].pcf85263;
+		if (pcf85263->century_en)
+			ret = pcf85263_century_store(pcf85263, tm);
+		if (!ret && pcf85263->drift)
+			ret = pcf85263_meta_store(pcf85263);
+		if (ret)
+			break;
+	}
+out:
+	pcf85263_group_unlock(group);
+
+	return ret;
+}
+
+static const struct rtc_class_ops pcf85263_group_ops = {
+	.read_time	= pcf85263_group_read_time,
+	.set_time	= pcf85263_group_set_time,
+};
+
+/* As of the last read: one line per member, name, state and offset */
+static ssize_t members_show(struct device *dev, struct device_attribute *attr,
+			    char *buf)
+{
+	struct pcf85263_group *group = dev_get_drvdata(dev);
+	ssize_t len = 0;
+	unsigned int i;
+
+	mutex_lock(&group->lock);
+	for (i = 0; i < group->num; i++) {
+		struct pcf85263_group_member *m = &group->members[i];
+
+		len += sprintf(buf + len, "%s %s",
+			       dev_name(&m->pcf85263->client->dev),
+			       pcf85263_group_states[m->state]);
+		if (m->state == GROUP_OK || m->state == GROUP_OUTLIER)
+			len += sprintf(buf + len, " %lld", m->offset_ms);
+		len += sprintf(buf + len, "\n");
+	}
+	mutex_unlock(&group->lock);
+
+	return len;
+}
+
+static DEVICE_ATTR_RO(members);
+
+static struct attribute *pcf85263_group_attrs[] = {
+	&dev_attr_members.attr,
+	NULL,
+};
+
+static const struct attribute_group pcf85263_group_attr_group = {
+	.attrs	= pcf85263_group_attrs,
+};
+
+static void pcf85263_group_put(void *data)
+{
+	put_device(data);
+}
+
+/*
+ * Look up member index of the group. Its probe runs with the device lock
+ * held, so holding it here sees the member either bound and complete or
+ * not bound at all. The device link then unbinds the group before any
+ * member goes away.
+ */
+static int pcf85263_group_add(struct pcf85263_group *group, int index)
+{
+	struct device *dev = group->dev;
+	struct pcf85263 *pcf85263 = NULL;
+	struct device_link *link = NULL;
+	struct i2c_client *client;
+	struct device_node *np;
+	int ret;
+
+	np = of_parse_phandle(dev->of_node, "nxp,rtcs", index);
+	if (!np)
+		return -EINVAL;
+	client = of_find_i2c_device_by_node(np);
+	of_node_put(np);
+	if (!client)
+		return -EPROBE_DEFER;
+
+	ret = devm_add_action_or_reset(dev, pcf85263_group_put, &client->dev);
+	if (ret)
+		return ret;
+
+	device_lock(&client->dev);
+	if (client->dev.driver == &pcf85263_driver.driver) {
+		pcf85263 = i2c_get_clientdata(client);
+		link = device_link_add(dev, &client->dev,
+				       DL_FLAG_AUTOREMOVE_CONSUMER);
+	}
+	device_unlock(&client->dev);
+
+	if (!pcf85263)
+		return -EPROBE_DEFER;
+	if (!link)
+		return -EINVAL;
+
+	group->members[group->num++].pcf85263 = pcf85263;
+
+	return 0;
+}
+
+static int pcf85263_group_probe(struct platform_device *pdev)
+{
+	struct device *dev = &pdev->dev;
+	struct pcf85263_group *group;
+	bool century = true;
+	int i, num, ret;
+
+	num = of_count_phandle_with_args(dev->of_node, "nxp,rtcs", NULL);
+	if (num < 2 || num > GROUP_MAX) {
+		dev_err(dev, "nxp,rtcs must name 2 to %d clocks\n", GROUP_MAX);
+		return -EINVAL;
+	}
+
+	group = devm_kzalloc(dev, sizeof(*group), GFP_KERNEL);
+	if (!group)
+		return -ENOMEM;
+
+	mutex_init(&group->lock);
+	group->dev = dev;
+	group->max_skew_ms = GROUP_SKEW_MS;
+	of_property_read_u32(dev->of_node, "nxp,max-skew-ms",
+			     &group->max_skew_ms);
+
+	for (i = 0; i < num; i++) {
+		ret = pcf85263_group_add(group, i);
+		if (ret)
+			return ret;
+		century &= group->members[i].pcf85263->century_en;
+	}
+
+	platform_set_drvdata(pdev, group);
+
+	group->rtc = devm_rtc_allocate_device(dev);
+	if (IS_ERR(group->rtc))
+		return PTR_ERR(group->rtc);
+
+	group->rtc->ops = &pcf85263_group_ops;
+	group->rtc->range_min = RTC_TIMESTAMP_BEGIN_2000;
+	group->rtc->range_max = century ? CENTURY_END : RTC_TIMESTAMP_END_2099;
+
+	ret = rtc_register_device(group->rtc);
+	if (ret)
+		return ret;
+
+	return devm_device_add_group(dev, &pcf85263_group_attr_group);
+}
+
+static const struct of_device_id pcf85263_group_of[] = {
+	{ .compatible = "nxp,pcf85263-group" },
+	{ }
+};
+
+MODULE_DEVICE_TABLE(of, pcf85263_group_of);
+
+static struct platform_driver pcf85263_group_driver = {
+	.driver	= {
+		.name	= "pcf85263-group",
+		.of_match_table = of_match_ptr(pcf85263_group_of),
+	},
+	.probe	= pcf85263_group_probe,
+};
+
+static int __init pcf85263_init(void)
+{
+	int ret;
+
+	ret = i2c_add_driver(&pcf85263_driver);
+	if (ret)
+		return ret;
+
+	ret = platform_driver_register(&pcf85263_group_driver);
+	if (ret)
+		i2c_del_driver(&pcf85263_driver);
+
+	return ret;
+}
+module_init(pcf85263_init);
+
+static void __exit pcf85263_exit(void)
+{
+	platform_driver_unregister(&pcf85263_group_driver);
+	i2c_del_driver(&pcf85263_driver);
+}
+module_exit(pcf85263_exit);
 
 MODULE_AUTHOR("Alan Morris");
 MODULE_DESCRIPTION("pcf85263 I2C RTC driver");
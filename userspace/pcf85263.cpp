@@ -0,0 +1,293 @@
+/*
+ * Userspace access to the NXP PCF85263/PCF85363 over i2c-dev.
+ *
+ * Every operation is a single I2C_RDWR ioctl, so it reaches the chip as
+ * one combined transaction with repeated starts and nothing else on the
+ * bus can get in between.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ */
+#include "pcf85263.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <system_error>
+
+#include <atomic>
+
+#include <fcntl.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <linux/i2c.h>
+#include <linux/i2c-dev.h>
+
+namespace pcf85263 {
+
+static unsigned int bcd2bin(uint8_t val)
+{
+	return (val & 0x0f) + (val >> 4) * 10;
+}
+
+static uint8_t bin2bcd(unsigned int val)
+{
+	return ((val / 10) << 4) | (val % 10);
+}
+
+hour_mode::hour_mode(bool h12)
+	: mask(h12 ? 0x1f : 0x3f), pm(h12 ? HOURS_PM : 0),
+	  mod(h12 ? 12 : 24), zero(h12 ? 12 : 0)
+{
+}
+
+unsigned int hour_mode::to_hour(uint8_t reg) const
+{
+	return bcd2bin(reg & mask) % mod + !!(reg & pm) * 12;
+}
+
+uint8_t hour_mode::to_reg(unsigned int hour) const
+{
+	unsigned int h = hour % mod;
+
+	return bin2bcd(h + !h * zero) | (hour >= 12) * pm;
+}
+
+void regs_to_time(const uint8_t *buf, const hour_mode &hm, struct timespec &ts)
+{
+	struct tm tm = {};
+
+	/* the oscillator stopped at some point, the time is garbage */
+	if (buf[DT_SECS] & SECS_OS)
+		throw std::runtime_error("oscillator stop detected, time is invalid");
+
+	tm.tm_year = bcd2bin(buf[DT_YEARS]) + 100;
+	tm.tm_mon = bcd2bin(buf[DT_MONTHS]) - 1;
+	tm.tm_mday = bcd2bin(buf[DT_DAYS]);
+	tm.tm_hour = hm.to_hour(buf[DT_HOURS]);
+	tm.tm_min = bcd2bin(buf[DT_MINUTES] & 0x7f);
+	tm.tm_sec = bcd2bin(buf[DT_SECS] & 0x7f);
+
+	ts.tv_sec = timegm(&tm);
+	ts.tv_nsec = bcd2bin(buf[DT_100THS]) * 10000000L;
+}
+
+void time_to_regs(const struct timespec &ts, const hour_mode &hm, uint8_t *buf)
+{
+	struct tm tm;
+
+	if (!gmtime_r(&ts.tv_sec, &tm) || tm.tm_year < 100 || tm.tm_year > 199)
+		throw std::out_of_range("time outside 2000-2099");
+
+	buf[DT_100THS] = bin2bcd(ts.tv_nsec / 10000000L);
+	buf[DT_SECS] = bin2bcd(tm.tm_sec);
+	buf[DT_MINUTES] = bin2bcd(tm.tm_min);
+	buf[DT_HOURS] = hm.to_reg(tm.tm_hour);
+	buf[DT_DAYS] = bin2bcd(tm.tm_mday);
+	buf[DT_WEEKDAYS] = tm.tm_wday;
+	buf[DT_MONTHS] = bin2bcd(tm.tm_mon + 1);
+	buf[DT_YEARS] = bin2bcd(tm.tm_year % 100);
+}
+
+device::device(int bus, uint16_t addr, bool ram)
+	: fd_(-1), addr_(addr), ram_(ram)
+{
+	char path[32];
+	uint8_t osc;
+
+	snprintf(path, sizeof(path), "/dev/i2c-%d", bus);
+	fd_ = open(path, O_RDWR | O_CLOEXEC);
+	if (fd_ < 0)
+		throw std::system_error(errno, std::generic_category(), path);
+
+	/* the hour mode is read once, like the driver does at probe */
+	try {
+		read(CTRL_OSCILLATOR, &osc, 1);
+	} catch (...) {
+		close(fd_);
+		throw;
+	}
+	hm_ = hour_mode(osc & OSC_12_24);
+}
+
+device::~device()
+{
+	close(fd_);
+}
+
+void device::transfer(struct i2c_msg *msgs, unsigned int num)
+{
+	struct i2c_rdwr_ioctl_data data = { msgs, num };
+	int ret;
+
+	ret = ioctl(fd_, I2C_RDWR, &data);
+	if (ret < 0)
+		throw std::system_error(errno, std::generic_category(),
+					"I2C_RDWR");
+	if ((unsigned int)ret != num)
+		throw std::system_error(EIO, std::generic_category(),
+					"I2C_RDWR");
+}
+
+void device::read(uint8_t reg, uint8_t *buf, size_t len)
+{
+	struct i2c_msg msgs[] = {
+		{ addr_, 0, 1, &reg },
+		{ addr_, I2C_M_RD, (uint16_t)len, buf },
+	};
+
+	transfer(msgs, 2);
+}
+
+void device::write(uint8_t reg, const uint8_t *buf, size_t len)
+{
+	std::vector<uint8_t> out(1 + len);
+	struct i2c_msg msg = { addr_, 0, (uint16_t)out.size(), out.data() };
+
+	out[0] = reg;
+	memcpy(out.data() + 1, buf, len);
+	transfer(&msg, 1);
+}
+
+struct timespec device::read_time()
+{
+	uint8_t buf[DT_YEARS + 1];
+	struct timespec ts;
+
+	/* read the RTC date and time registers all at once */
+	read(DT_100THS, buf, sizeof(buf));
+	regs_to_time(buf, hm_, ts);
+
+	return ts;
+}
+
+/*
+ * Stop the clock, clear the prescaler and write the whole time block in
+ * one burst: the register address wraps from CTRL_RESETS to DT_100THS.
+ * The restart follows in the same transaction, so the clock is stopped
+ * for no longer than the bus takes to send it.
+ */
+void device::set_time(const struct timespec &ts)
+{
+	uint8_t burst[3 + DT_YEARS + 1] = {
+		CTRL_STOP_EN, STOP_EN_STOP, RESET_CPR,
+	};
+	uint8_t start[2] = { CTRL_STOP_EN, 0 };
+	struct i2c_msg msgs[] = {
+		{ addr_, 0, sizeof(burst), burst },
+		{ addr_, 0, sizeof(start), start },
+	};
+
+	time_to_regs(ts, hm_, burst + 3);
+	transfer(msgs, 2);
+}
+
+struct status device::read_status()
+{
+	uint8_t buf[STATUS_SIZE];
+	struct status st = {};
+
+	read(CTRL_FLAGS, buf, sizeof(buf));
+	st.flags = buf[0];
+	st.stop_en = buf[CTRL_STOP_EN - CTRL_FLAGS];
+	st.time_valid = !(buf[STATUS_TIME + DT_SECS] & SECS_OS);
+	if (st.time_valid)
+		regs_to_time(buf + STATUS_TIME, hm_, st.time);
+
+	return st;
+}
+
+/* Register file and RAM in one transaction, in the driver's dump format */
+std::vector<uint8_t> device::dump()
+{
+	const size_t hdr_len = 16;
+	size_t ram_len = ram_ ? RAM_SIZE : 0;
+	std::vector<uint8_t> out(hdr_len + SNAPSHOT_SIZE + ram_len);
+	uint8_t addr[2] = { DT_100THS, CTRL_RAM };
+	struct i2c_msg msgs[] = {
+		{ addr_, 0, 1, &addr[0] },
+		{ addr_, I2C_M_RD, SNAPSHOT_SIZE, out.data() + hdr_len },
+		/* only sent with RAM, out has no room past the registers */
+		{ addr_, 0, 1, &addr[1] },
+		{ addr_, I2C_M_RD, (uint16_t)ram_len,
+		  out.data() + hdr_len + SNAPSHOT_SIZE },
+	};
+	struct timespec now;
+	uint64_t ns;
+	int i;
+
+	memcpy(out.data(), REGDUMP_MAGIC, 4);
+	out[4] = REGDUMP_VERSION;
+	out[5] = SNAPSHOT_SIZE;
+	out[6] = ram_len;
+	out[7] = 0;
+
+	clock_gettime(CLOCK_REALTIME, &now);
+	ns = (uint64_t)now.tv_sec * 1000000000ULL + now.tv_nsec;
+	for (i = 0; i < 8; i++)
+		out[8 + i] = ns >> (8 * i);
+
+	transfer(msgs, ram_len ? 4 : 2);
+
+	return out;
+}
+
+time_page::time_page(const char *path)
+{
+	int fd = open(path, O_RDONLY | O_CLOEXEC);
+	void *p;
+
+	if (fd < 0)
+		throw std::system_error(errno, std::generic_category(), path);
+
+	p = mmap(NULL, sysconf(_SC_PAGESIZE), PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if (p == MAP_FAILED)
+		throw std::system_error(errno, std::generic_category(), "mmap");
+
+	page_ = static_cast<const volatile struct pcf85263_time_page *>(p);
+	if (page_->version != PCF85263_PAGE_VERSION) {
+		munmap(p, sysconf(_SC_PAGESIZE));
+		throw std::runtime_error("unsupported time page version");
+	}
+}
+
+time_page::~time_page()
+{
+	munmap(const_cast<struct pcf85263_time_page *>(page_),
+	       sysconf(_SC_PAGESIZE));
+}
+
+bool time_page::now(struct timespec &ts) const
+{
+	int64_t sec, nsec;
+	uint64_t mono;
+	uint32_t seq, flags;
+	struct timespec t;
+
+	/* the driver side is a seqcount, see pcf85263-page.h */
+	do {
+		seq = page_->seq;
+		std::atomic_thread_fence(std::memory_order_acquire);
+		flags = page_->flags;
+		sec = page_->rtc_sec;
+		nsec = page_->rtc_nsec;
+		mono = page_->mono_ns;
+		std::atomic_thread_fence(std::memory_order_acquire);
+	} while ((seq & 1) || page_->seq != seq);
+
+	if (!(flags & PCF85263_PAGE_VALID))
+		return false;
+
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	nsec += (int64_t)t.tv_sec * 1000000000LL + t.tv_nsec - (int64_t)mono;
+	ts.tv_sec = sec + nsec / 1000000000LL;
+	ts.tv_nsec = nsec % 1000000000LL;
+
+	return true;
+}
+
+}
@@ -0,0 +1,116 @@
+/*
+ * Userspace access to the NXP PCF85263/PCF85363 over i2c-dev, for systems
+ * that cannot load rtc-pcf85263. The register map is the driver's, and the
+ * time conversion follows the same rules: BCD with hundredths, the 12/24
+ * hour mode read once when the device is opened, 2000-2099, and a stopped
+ * oscillator makes the time invalid.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ */
+#ifndef PCF85263_H
+#define PCF85263_H
+
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+#include <vector>
+
+#ifndef BIT
+#define BIT(n)		(1U << (n))
+#endif
+#ifndef GENMASK
+#define GENMASK(h, l)	((~0U << (l)) & (~0U >> (31 - (h))))
+#endif
+
+#include "../pcf85263-regs.h"
+#include "../pcf85263-page.h"
+
+struct i2c_msg;
+
+namespace pcf85263 {
+
+/* CTRL_FLAGS and the time, read in the same transfer */
+struct status {
+	uint8_t		flags;
+	uint8_t		stop_en;
+	bool		time_valid;
+	struct timespec	time;
+};
+
+/*
+ * Hours register conversion for the mode the chip is in, the same
+ * arithmetic as the driver: in 24-hour mode it is plain BCD.
+ */
+struct hour_mode {
+	uint8_t	mask;
+	uint8_t	pm;
+	uint8_t	mod;
+	uint8_t	zero;
+
+	explicit hour_mode(bool h12 = false);
+	unsigned int to_hour(uint8_t reg) const;
+	uint8_t to_reg(unsigned int hour) const;
+};
+
+/*
+ * buf holds DT_100THS..DT_YEARS. regs_to_time() throws std::runtime_error
+ * when the oscillator stop flag is set, time_to_regs() std::out_of_range
+ * outside 2000-2099.
+ */
+void regs_to_time(const uint8_t *buf, const hour_mode &hm, struct timespec &ts);
+void time_to_regs(const struct timespec &ts, const hour_mode &hm, uint8_t *buf);
+
+class device {
+public:
+	/* /dev/i2c-<bus>; ram selects the PCF85363 RAM for dumps */
+	explicit device(int bus, uint16_t addr = 0x51, bool ram = false);
+	~device();
+
+	device(const device &) = delete;
+	device &operator=(const device &) = delete;
+
+	struct timespec read_time();
+	void set_time(const struct timespec &ts);
+	struct status read_status();
+	std::vector<uint8_t> dump();
+
+	void read(uint8_t reg, uint8_t *buf, size_t len);
+	void write(uint8_t reg, const uint8_t *buf, size_t len);
+
+	bool h12() const { return hm_.mod == 12; }
+
+private:
+	void transfer(struct i2c_msg *msgs, unsigned int num);
+
+	int		fd_;
+	uint16_t	addr_;
+	bool		ram_;
+	hour_mode	hm_;
+};
+
+/*
+ * The time page of a driver bound with nxp,time-page, mapped read-only
+ * from /dev/pcf85263-<bus>-<addr>. now() takes no syscall beyond the vDSO
+ * clock_gettime() and never touches the bus; it returns false until the
+ * driver has a valid sample.
+ */
+class time_page {
+public:
+	explicit time_page(const char *path);
+	~time_page();
+
+	time_page(const time_page &) = delete;
+	time_page &operator=(const time_page &) = delete;
+
+	bool now(struct timespec &ts) const;
+	uint32_t interval_ms() const { return page_->interval_ms; }
+
+private:
+	const volatile struct pcf85263_time_page *page_;
+};
+
+}
+
+#endif /* PCF85263_H */
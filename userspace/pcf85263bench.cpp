@@ -0,0 +1,468 @@
+/*
+ * pcf85263bench - latency, concurrency and accuracy of an RTC
+ *
+ * Measures read (and with -w, set) latency percentiles for 1..N threads,
+ * the offset of the RTC against CLOCK_REALTIME found the way hwclock does,
+ * by waiting for the RTC to tick, and the error left by a set. Results go
+ * to stdout as JSON.
+ *
+ * Backends: /dev/rtcN through the rtc ioctls (the driver's read_time and
+ * set_time), the chip directly over i2c-dev through libpcf85263, the
+ * driver's read-only time page, or a simulated chip, on libpcf85263's
+ * register encoding and a simulated 100 kHz bus, for runs without hardware.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ */
+#include "pcf85263.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+#include <linux/rtc.h>
+
+#define NSEC_PER_SEC	1000000000LL
+
+static long long ts_ns(const struct timespec &ts)
+{
+	return ts.tv_sec * NSEC_PER_SEC + ts.tv_nsec;
+}
+
+static long long now_ns(clockid_t clk)
+{
+	struct timespec ts;
+
+	clock_gettime(clk, &ts);
+	return ts_ns(ts);
+}
+
+struct backend {
+	virtual ~backend() {}
+	virtual const char *name() const = 0;
+	/* the smallest step the time read back can take */
+	virtual long long resolution_ns() const = 0;
+	virtual void read(struct timespec &ts) = 0;
+	virtual void set(const struct timespec &ts) = 0;
+};
+
+/* The kernel driver, through /dev/rtcN. The rtc ioctls carry seconds. */
+struct rtc_backend : backend {
+	int fd;
+
+	explicit rtc_backend(const char *path)
+	{
+		fd = open(path, O_RDWR | O_CLOEXEC);
+		if (fd < 0)
+			throw std::system_error(errno, std::generic_category(),
+						path);
+	}
+
+	~rtc_backend()
+	{
+		close(fd);
+	}
+
+	const char *name() const { return "rtc"; }
+	long long resolution_ns() const { return NSEC_PER_SEC; }
+
+	void read(struct timespec &ts)
+	{
+		struct rtc_time rt;
+		struct tm tm = {};
+
+		if (ioctl(fd, RTC_RD_TIME, &rt) < 0)
+			throw std::system_error(errno, std::generic_category(),
+						"RTC_RD_TIME");
+		tm.tm_sec = rt.tm_sec;
+		tm.tm_min = rt.tm_min;
+		tm.tm_hour = rt.tm_hour;
+		tm.tm_mday = rt.tm_mday;
+		tm.tm_mon = rt.tm_mon;
+		tm.tm_year = rt.tm_year;
+		ts.tv_sec = timegm(&tm);
+		ts.tv_nsec = 0;
+	}
+
+	void set(const struct timespec &ts)
+	{
+		struct rtc_time rt = {};
+		struct tm tm;
+
+		gmtime_r(&ts.tv_sec, &tm);
+		rt.tm_sec = tm.tm_sec;
+		rt.tm_min = tm.tm_min;
+		rt.tm_hour = tm.tm_hour;
+		rt.tm_mday = tm.tm_mday;
+		rt.tm_mon = tm.tm_mon;
+		rt.tm_year = tm.tm_year;
+		rt.tm_wday = tm.tm_wday;
+		if (ioctl(fd, RTC_SET_TIME, &rt) < 0)
+			throw std::system_error(errno, std::generic_category(),
+						"RTC_SET_TIME");
+	}
+};
+
+/* The chip over i2c-dev, with hundredths */
+struct i2c_backend : backend {
+	pcf85263::device dev;
+
+	i2c_backend(int bus, uint16_t addr) : dev(bus, addr) {}
+
+	const char *name() const { return "i2c"; }
+	long long resolution_ns() const { return NSEC_PER_SEC / 100; }
+
+	void read(struct timespec &ts) { ts = dev.read_time(); }
+	void set(const struct timespec &ts) { dev.set_time(ts); }
+};
+
+/* The driver's time page: neither a syscall nor a bus transfer per read */
+struct page_backend : backend {
+	pcf85263::time_page page;
+
+	explicit page_backend(const char *path) : page(path) {}
+
+	const char *name() const { return "page"; }
+	long long resolution_ns() const { return 1; }
+
+	void read(struct timespec &ts)
+	{
+		if (!page.now(ts))
+			throw std::runtime_error("no valid sample in the time page");
+	}
+
+	void set(const struct timespec &)
+	{
+		throw std::runtime_error("the time page is read only");
+	}
+};
+
+/*
+ * A PCF85263 on a simulated 100 kHz bus, for runs without hardware. The
+ * chip is its time block, encoded with time_to_regs() and read back with
+ * regs_to_time() like the i2c backend, so it has the chip's hundredths.
+ * The transfers are the ones libpcf85263 sends: the register address and
+ * an 8 byte read for the time, and for a set one burst that stops the
+ * clock, clears the prescaler and writes the time block, then the
+ * restart. The bus is one mutex held for as long as the bytes take.
+ */
+struct sim_backend : backend {
+	std::mutex bus;
+	pcf85263::hour_mode hm;
+	uint8_t regs[DT_YEARS + 1];	/* the time block as last written */
+	long long start_ns;		/* CLOCK_MONOTONIC at the restart */
+
+	sim_backend()
+	{
+		struct timespec ts;
+
+		clock_gettime(CLOCK_REALTIME, &ts);
+		pcf85263::time_to_regs(ts, hm, regs);
+		start_ns = now_ns(CLOCK_MONOTONIC);
+	}
+
+	const char *name() const { return "sim"; }
+	long long resolution_ns() const { return NSEC_PER_SEC / 100; }
+
+	void xfer(unsigned int bytes)
+	{
+		/* start, address, bytes, 9 bit times each, stop */
+		std::this_thread::sleep_for(std::chrono::microseconds(
+			(bytes + 1) * 9 * 10 + 20));
+	}
+
+	/* The counters as the chip latches them now */
+	void latch(uint8_t *buf)
+	{
+		struct timespec ts;
+		long long t;
+
+		pcf85263::regs_to_time(regs, hm, ts);
+		t = ts_ns(ts) + now_ns(CLOCK_MONOTONIC) - start_ns;
+		ts.tv_sec = t / NSEC_PER_SEC;
+		ts.tv_nsec = t % NSEC_PER_SEC;
+		pcf85263::time_to_regs(ts, hm, buf);
+	}
+
+	void read(struct timespec &ts)
+	{
+		std::lock_guard<std::mutex> lock(bus);
+		uint8_t buf[DT_YEARS + 1];
+
+		/* latched at the repeated start, after the register address */
+		xfer(1);
+		latch(buf);
+		xfer(sizeof(buf));
+		pcf85263::regs_to_time(buf, hm, ts);
+	}
+
+	void set(const struct timespec &ts)
+	{
+		std::lock_guard<std::mutex> lock(bus);
+		uint8_t buf[DT_YEARS + 1];
+
+		pcf85263::time_to_regs(ts, hm, buf);
+		xfer(3 + sizeof(buf));
+		memcpy(regs, buf, sizeof(regs));
+		/* with the prescaler cleared, counting starts at the restart */
+		xfer(2);
+		start_ns = now_ns(CLOCK_MONOTONIC);
+	}
+};
+
+struct latency {
+	unsigned int threads;
+	double ops_per_sec;
+	double p50_us, p90_us, p99_us, max_us;
+};
+
+static double percentile(const std::vector<double> &v, double p)
+{
+	size_t i = std::min(v.size() - 1, (size_t)(p * v.size()));
+
+	return v[i];
+}
+
+/* Run iters operations on each of threads threads at once */
+static latency run(backend &b, unsigned int threads, unsigned int iters,
+		   bool set)
+{
+	std::vector<std::vector<double> > samples(threads);
+	std::vector<std::thread> workers;
+	std::vector<double> all;
+	long long start, end;
+	latency l = {};
+
+	start = now_ns(CLOCK_MONOTONIC);
+	for (unsigned int t = 0; t < threads; t++) {
+		workers.emplace_back([&b, &samples, t, iters, set]() {
+			struct timespec ts;
+
+			for (unsigned int i = 0; i < iters; i++) {
+				long long t0 = now_ns(CLOCK_MONOTONIC);
+
+				if (set) {
+					clock_gettime(CLOCK_REALTIME, &ts);
+					b.set(ts);
+				} else {
+					b.read(ts);
+				}
+				samples[t].push_back(
+					(now_ns(CLOCK_MONOTONIC) - t0) / 1e3);
+			}
+		});
+	}
+	for (auto &w : workers)
+		w.join();
+	end = now_ns(CLOCK_MONOTONIC);
+
+	for (auto &s : samples)
+		all.insert(all.end(), s.begin(), s.end());
+	std::sort(all.begin(), all.end());
+
+	l.threads = threads;
+	l.ops_per_sec = all.size() * 1e9 / (end - start);
+	l.p50_us = percentile(all, 0.50);
+	l.p90_us = percentile(all, 0.90);
+	l.p99_us = percentile(all, 0.99);
+	l.max_us = all.back();
+
+	return l;
+}
+
+/*
+ * Wait for the RTC to step, like hwclock does, and return RTC time minus
+ * CLOCK_REALTIME at that moment in ms. The step happens somewhere between
+ * the last two reads, so the midpoint is used.
+ */
+static double edge_offset_ms(backend &b)
+{
+	struct timespec first, ts;
+	long long before, after;
+
+	b.read(first);
+	after = now_ns(CLOCK_REALTIME);
+	do {
+		before = after;
+		b.read(ts);
+		after = now_ns(CLOCK_REALTIME);
+	} while (ts_ns(ts) == ts_ns(first));
+
+	return (ts_ns(ts) - (before + after) / 2) / 1e6;
+}
+
+struct stats {
+	unsigned int n;
+	double mean, min, max;
+};
+
+static stats summarize(const std::vector<double> &v)
+{
+	stats s = { (unsigned int)v.size(), 0, v[0], v[0] };
+
+	for (double x : v) {
+		s.mean += x;
+		s.min = std::min(s.min, x);
+		s.max = std::max(s.max, x);
+	}
+	s.mean /= v.size();
+
+	return s;
+}
+
+static void print_latencies(const char *key, const std::vector<latency> &v)
+{
+	printf("  \"%s\": [\n", key);
+	for (size_t i = 0; i < v.size(); i++)
+		printf("    { \"threads\": %u, \"ops_per_sec\": %.1f, "
+		       "\"p50_us\": %.1f, \"p90_us\": %.1f, \"p99_us\": %.1f, "
+		       "\"max_us\": %.1f }%s\n",
+		       v[i].threads, v[i].ops_per_sec, v[i].p50_us,
+		       v[i].p90_us, v[i].p99_us, v[i].max_us,
+		       i + 1 < v.size() ? "," : "");
+	printf("  ],\n");
+}
+
+static void print_stats(const char *key, const stats &s, bool last)
+{
+	printf("  \"%s\": { \"samples\": %u, \"mean\": %.3f, \"min\": %.3f, "
+	       "\"max\": %.3f }%s\n", key, s.n, s.mean, s.min, s.max,
+	       last ? "" : ",");
+}
+
+static void usage(const char *prog)
+{
+	fprintf(stderr,
+		"usage: %s [-d /dev/rtcN | -b BUS [-a ADDR] | -p DEV | -s]\n"
+		"          [-t THREADS]\n"
+		"          [-n ITERATIONS] [-e EDGES] [-w]\n"
+		"  -d DEV   the driver through an rtc device (default /dev/rtc0)\n"
+		"  -b BUS   the chip directly on /dev/i2c-BUS\n"
+		"  -p DEV   the driver's time page, /dev/pcf85263-BUS-ADDR\n"
+		"  -s       a simulated chip\n"
+		"  -t N     up to N concurrent threads, doubling from 1 (default 4)\n"
+		"  -n N     operations per thread (default 200)\n"
+		"  -e N     RTC edges to sample for the offset (default 5)\n"
+		"  -w       also benchmark set; leaves the RTC set to system time\n",
+		prog);
+}
+
+int main(int argc, char **argv)
+{
+	const char *dev = "/dev/rtc0", *page = NULL;
+	unsigned int threads = 4, iters = 200, edges = 5;
+	unsigned long addr = 0x51;
+	bool write = false, sim = false;
+	int bus = -1;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "d:b:a:p:st:n:e:wh")) != -1) {
+		switch (opt) {
+		case 'd':
+			dev = optarg;
+			break;
+		case 'b':
+			bus = atoi(optarg);
+			break;
+		case 'a':
+			addr = strtoul(optarg, NULL, 0);
+			break;
+		case 'p':
+			page = optarg;
+			break;
+		case 's':
+			sim = true;
+			break;
+		case 't':
+			threads = strtoul(optarg, NULL, 0);
+			break;
+		case 'n':
+			iters = strtoul(optarg, NULL, 0);
+			break;
+		case 'e':
+			edges = strtoul(optarg, NULL, 0);
+			break;
+		case 'w':
+			write = true;
+			break;
+		default:
+			usage(argv[0]);
+			return opt == 'h' ? 0 : 2;
+		}
+	}
+
+	if (!threads || !iters || !edges) {
+		usage(argv[0]);
+		return 2;
+	}
+
+	try {
+		std::unique_ptr<backend> b;
+		std::vector<latency> reads, sets;
+		std::vector<double> offsets, errors;
+		struct timespec ts;
+
+		if (sim)
+			b.reset(new sim_backend());
+		else if (page)
+			b.reset(new page_backend(page));
+		else if (bus >= 0)
+			b.reset(new i2c_backend(bus, addr));
+		else
+			b.reset(new rtc_backend(dev));
+
+		for (unsigned int t = 1; t <= threads; t *= 2)
+			reads.push_back(run(*b, t, iters, false));
+
+		for (unsigned int i = 0; i < edges; i++)
+			offsets.push_back(edge_offset_ms(*b));
+
+		if (write) {
+			for (unsigned int t = 1; t <= threads; t *= 2)
+				sets.push_back(run(*b, t, iters / 10 + 1,
+						   true));
+
+			/* set at a random point in the second, then look */
+			for (unsigned int i = 0; i < edges; i++) {
+				usleep(rand() % 1000000);
+				clock_gettime(CLOCK_REALTIME, &ts);
+				b->set(ts);
+				errors.push_back(edge_offset_ms(*b));
+			}
+		}
+
+		printf("{\n");
+		printf("  \"backend\": \"%s\",\n", b->name());
+		printf("  \"resolution_ms\": %.3f,\n",
+		       b->resolution_ns() / 1e6);
+		printf("  \"iterations\": %u,\n", iters);
+		print_latencies("read", reads);
+		if (write) {
+			print_latencies("set", sets);
+			print_stats("set_error_ms", summarize(errors), false);
+		}
+		print_stats("realtime_offset_ms", summarize(offsets), true);
+		printf("}\n");
+	} catch (const std::exception &e) {
+		fprintf(stderr, "%s\n", e.what());
+		return 1;
+	}
+
+	return 0;
+}
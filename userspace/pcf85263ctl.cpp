@@ -0,0 +1,181 @@
+/*
+ * pcf85263ctl - read and set a PCF85263/PCF85363 over i2c-dev
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ */
+#include "pcf85263.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+
+#include <sys/time.h>
+#include <unistd.h>
+
+static void usage(const char *prog)
+{
+	fprintf(stderr,
+		"usage: %s [-b BUS] [-a ADDR] [-3] COMMAND\n"
+		"       %s page /dev/pcf85263-BUS-ADDR\n"
+		"  -b BUS      i2c bus number, /dev/i2c-BUS (default 2)\n"
+		"  -a ADDR     chip address (default 0x51)\n"
+		"  -3          PCF85363, include the RAM in dumps\n"
+		"commands:\n"
+		"  get                          print the time (UTC)\n"
+		"  set 'YYYY-MM-DD HH:MM:SS[.hh]'|now\n"
+		"                               set the time (UTC)\n"
+		"  hctosys                      set the system clock from the RTC\n"
+		"  status                       flags and time from one read\n"
+		"  dump [-x]                    registers (and RAM), binary or hex\n"
+		"  page DEV                     the time from the driver's time page\n",
+		prog, prog);
+}
+
+static void print_time(const struct timespec &ts)
+{
+	struct tm tm;
+	char buf[32];
+
+	gmtime_r(&ts.tv_sec, &tm);
+	strftime(buf, sizeof(buf), "%Y-%m-%d %H:%M:%S", &tm);
+	printf("%s.%02ld\n", buf, ts.tv_nsec / 10000000L);
+}
+
+static bool parse_time(const char *arg, struct timespec &ts)
+{
+	unsigned int hths = 0;
+	struct tm tm = {};
+	const char *end;
+
+	if (!strcmp(arg, "now")) {
+		clock_gettime(CLOCK_REALTIME, &ts);
+		return true;
+	}
+
+	end = strptime(arg, "%Y-%m-%d %H:%M:%S", &tm);
+	if (!end)
+		return false;
+	if (*end == '.') {
+		char *p;
+
+		hths = strtoul(end + 1, &p, 10);
+		if (p != end + 3 || *p)
+			return false;
+	} else if (*end) {
+		return false;
+	}
+
+	ts.tv_sec = timegm(&tm);
+	ts.tv_nsec = hths * 10000000L;
+
+	return true;
+}
+
+static void hexdump(const std::vector<uint8_t> &buf)
+{
+	size_t i;
+
+	for (i = 0; i < buf.size(); i++)
+		printf("%02x%c", buf[i], i % 16 == 15 ? '\n' : ' ');
+	if (i % 16)
+		putchar('\n');
+}
+
+int main(int argc, char **argv)
+{
+	unsigned long addr = 0x51;
+	bool ram = false;
+	int bus = 2;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "+b:a:3h")) != -1) {
+		switch (opt) {
+		case 'b':
+			bus = atoi(optarg);
+			break;
+		case 'a':
+			addr = strtoul(optarg, NULL, 0);
+			break;
+		case '3':
+			ram = true;
+			break;
+		default:
+			usage(argv[0]);
+			return opt == 'h' ? 0 : 2;
+		}
+	}
+
+	if (optind >= argc) {
+		usage(argv[0]);
+		return 2;
+	}
+
+	try {
+		const char *cmd = argv[optind];
+
+		/* no bus access at all, so no device to open */
+		if (!strcmp(cmd, "page") && optind + 1 < argc) {
+			pcf85263::time_page page(argv[optind + 1]);
+			struct timespec ts;
+
+			if (!page.now(ts)) {
+				fprintf(stderr, "no valid sample yet\n");
+				return 1;
+			}
+			print_time(ts);
+			return 0;
+		}
+
+		pcf85263::device dev(bus, addr, ram);
+
+		if (!strcmp(cmd, "get")) {
+			print_time(dev.read_time());
+		} else if (!strcmp(cmd, "set") && optind + 1 < argc) {
+			struct timespec ts;
+
+			if (!parse_time(argv[optind + 1], ts)) {
+				fprintf(stderr, "invalid time: %s\n",
+					argv[optind + 1]);
+				return 2;
+			}
+			dev.set_time(ts);
+		} else if (!strcmp(cmd, "hctosys")) {
+			struct timespec ts = dev.read_time();
+			struct timeval tv = { ts.tv_sec, ts.tv_nsec / 1000 };
+
+			if (settimeofday(&tv, NULL)) {
+				perror("settimeofday");
+				return 1;
+			}
+		} else if (!strcmp(cmd, "status")) {
+			struct pcf85263::status st = dev.read_status();
+
+			printf("flags 0x%02x%s%s\n", st.flags,
+			       st.stop_en & STOP_EN_STOP ? ", stopped" : "",
+			       dev.h12() ? ", 12h" : "");
+			if (st.time_valid)
+				print_time(st.time);
+			else
+				printf("time invalid (oscillator stopped)\n");
+		} else if (!strcmp(cmd, "dump")) {
+			std::vector<uint8_t> buf = dev.dump();
+
+			if (optind + 1 < argc && !strcmp(argv[optind + 1], "-x"))
+				hexdump(buf);
+			else if (fwrite(buf.data(), 1, buf.size(), stdout) !=
+				 buf.size())
+				return 1;
+		} else {
+			usage(argv[0]);
+			return 2;
+		}
+	} catch (const std::exception &e) {
+		fprintf(stderr, "%s\n", e.what());
+		return 1;
+	}
+
+	return 0;
+}